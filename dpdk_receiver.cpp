@@ -1,12 +1,23 @@
 #include <iostream>
-#include <iomanip>
-#include <chrono>
-#include <thread>
-#include <atomic>
-#include <csignal>
 #include <array>
-#include <memory>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+
+#include "bench_proto.h"
+#include "burst_profile.h"
+#include "capture_writer.h"
+#include "dpdk_counters.h"
+#include "dpdk_launch.h"
+#include "engine.h"
+#include "options.h"
+#include "poll_policy.h"
+#include "runner.h"
 #include <rte_eal.h>
+#include <rte_cycles.h>
+#include <rte_epoll.h>
 #include <rte_ethdev.h>
 #include <rte_mbuf.h>
 
@@ -16,18 +27,6 @@ constexpr uint16_t NUM_MBUFS = 8191;
 constexpr uint16_t MBUF_CACHE_SIZE = 250;
 constexpr uint16_t BURST_SIZE = 32;
 
-struct Stats {
-    std::atomic<uint64_t> total_packets{0};
-    std::atomic<uint64_t> total_bytes{0};
-    std::atomic<uint64_t> bytes_second{0};
-    std::atomic<uint64_t> packets_second{0};
-    std::chrono::steady_clock::time_point start_time;
-};
-
-static Stats global_stats;
-static std::atomic<bool> force_quit{false};
-static bool use_sleep = true;
-
 static const struct rte_eth_conf port_conf_default = {
     .link_speeds = 0,
     .rxmode = {
@@ -55,39 +54,12 @@ static const struct rte_eth_conf port_conf_default = {
     .intr_conf = {}
 };
 
-std::string format_unit(double value) {
-    const std::array<std::string, 5> units = {"", "K", "M", "G", "T"};
-    int i = 0;
-    while (value >= 1000.0 && i < 4) {
-        value /= 1000.0;
-        i++;
-    }
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2) << value << " " << units[i];
-    return oss.str();
-}
-
-void print_stats() {
-    std::cout << "\rStats: " 
-              << format_unit(global_stats.total_packets.load()) << "-packets, "
-              << format_unit(global_stats.total_bytes.load()) << "bytes, "
-              << format_unit(global_stats.packets_second.load()) << "-packets/s, "
-              << format_unit(global_stats.bytes_second.load()) << "b/s   " << std::flush;
-    
-    global_stats.packets_second = 0;
-    global_stats.bytes_second = 0;
-}
-
-void signal_handler(int signum) {
-    if (signum == SIGINT || signum == SIGTERM) {
-        std::cout << "\nSignal " << signum << " received, preparing to exit..." << std::endl;
-        force_quit = true;
-    }
-}
-
-int port_init(uint16_t port, rte_mempool* mbuf_pool) {
+int port_init(uint16_t port, rte_mempool* mbuf_pool, uint16_t rx_rings, bool reflect, bool rx_intr) {
     struct rte_eth_conf port_conf = port_conf_default;
-    const uint16_t rx_rings = 1, tx_rings = 0;
+    // --poll interrupt: ожидание прерывания очереди RX
+    port_conf.intr_conf.rxq = rx_intr;
+    // Отражение через очередь TX в паре с RX
+    const uint16_t tx_rings = reflect ? rx_rings : 0;
     uint16_t nb_rxd = RX_RING_SIZE;
     uint16_t nb_txd = TX_RING_SIZE;
 
@@ -101,6 +73,23 @@ int port_init(uint16_t port, rte_mempool* mbuf_pool) {
         return retval;
     }
 
+    if (rx_rings > dev_info.max_rx_queues) {
+        std::cerr << "Port " << port << " supports only " << dev_info.max_rx_queues << " RX queues" << std::endl;
+        return -EINVAL;
+    }
+
+    if (rx_rings > 1) {
+        // Распределение потоков по очередям через RSS
+        port_conf.rxmode.mq_mode = RTE_ETH_MQ_RX_RSS;
+        port_conf.rx_adv_conf.rss_conf.rss_key = nullptr;
+        port_conf.rx_adv_conf.rss_conf.rss_hf =
+            (RTE_ETH_RSS_IP | RTE_ETH_RSS_UDP | RTE_ETH_RSS_TCP) & dev_info.flow_type_rss_offloads;
+        if (port_conf.rx_adv_conf.rss_conf.rss_hf == 0) {
+            std::cerr << "Port " << port << " does not support RSS" << std::endl;
+            return -ENOTSUP;
+        }
+    }
+
     retval = rte_eth_dev_configure(port, rx_rings, tx_rings, &port_conf);
     if (retval != 0)
         return retval;
@@ -118,6 +107,15 @@ int port_init(uint16_t port, rte_mempool* mbuf_pool) {
             return retval;
     }
 
+    rte_eth_txconf txconf = dev_info.default_txconf;
+    txconf.offloads = port_conf.txmode.offloads;
+    for (uint16_t q = 0; q < tx_rings; q++) {
+        retval = rte_eth_tx_queue_setup(port, q, nb_txd,
+                rte_eth_dev_socket_id(port), &txconf);
+        if (retval < 0)
+            return retval;
+    }
+
     retval = rte_eth_dev_start(port);
     if (retval < 0)
         return retval;
@@ -125,32 +123,186 @@ int port_init(uint16_t port, rte_mempool* mbuf_pool) {
     return 0;
 }
 
-void receive_packets(uint16_t portid) {
-    while (!force_quit) {
+// Приём через DPDK: с --rss очередь RX на каждый lcore
+class DpdkRxEngine : public RxEngine {
+public:
+    DpdkRxEngine(const Options &opts, bool use_rss, bool profile) : opts(opts), use_rss(use_rss), profile(profile) {}
+
+    bool setup() override;
+    unsigned nb_workers() const override { return nb_queues; }
+    void receive(unsigned worker_id, WorkerStats &stats, StreamTable &streams) override;
+    void launch(const WorkerBody &body) override;
+    void report(std::ostream &os) const override;
+    void device_counters(DeviceCounters *counters) override {
+        port_counters.read(counters);
+        capture.counters(counters);
+    }
+
+private:
+    const Options &opts;
+    bool use_rss;
+    bool profile;
+    uint16_t portid = 0;
+    uint16_t nb_queues = 1;
+    PollMode poll_mode = PollMode::Adaptive;
+    DpdkPortCounters port_counters;
+    std::vector<BurstProfileData> profiles;  // по одному на очередь с --profile
+    CaptureSet capture;                      // --record
+
+    template <bool Profile>
+    void receive_loop(unsigned worker_id, WorkerStats &ws, StreamTable &streams, BurstProfileData *profile_data);
+};
+
+bool DpdkRxEngine::setup() {
+    if (!parse_poll_mode(opts, &poll_mode)) {
+        std::cerr << "Unknown poll mode: " << opts.poll << " (expected busy, adaptive or interrupt)" << std::endl;
+        return false;
+    }
+
+    if (use_rss) {
+        nb_queues = rte_lcore_count() - 1;
+        if (nb_queues == 0)
+            rte_exit(EXIT_FAILURE, "--rss needs at least one worker lcore (e.g. -l 0-3)\n");
+    }
+
+    unsigned nb_mbufs = std::max<unsigned>(NUM_MBUFS, nb_queues * (RX_RING_SIZE + BURST_SIZE + MBUF_CACHE_SIZE));
+    auto mbuf_pool = rte_pktmbuf_pool_create("MBUF_POOL", nb_mbufs,
+        MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+
+    if (mbuf_pool == nullptr)
+        rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
+
+    int retval = port_init(portid, mbuf_pool, nb_queues, opts.reflect, poll_mode == PollMode::Interrupt);
+    if (retval != 0 && poll_mode == PollMode::Interrupt) {
+        // Драйверы без прерываний RX отказывают в intr_conf.rxq
+        std::cerr << "Port " << portid << " does not start with RX interrupts (" << strerror(-retval)
+                  << "), idle polls sleep instead" << std::endl;
+        rte_eth_dev_stop(portid);
+        poll_mode = PollMode::Adaptive;
+        retval = port_init(portid, mbuf_pool, nb_queues, opts.reflect, false);
+    }
+    if (retval != 0)
+        rte_exit(EXIT_FAILURE, "Cannot init port %" PRIu16 "\n", portid);
+    port_counters.init(portid);
+
+    if (profile) {
+        profiles.resize(nb_queues);
+    }
+    if (!capture.open(opts, nb_queues)) {
+        return false;
+    }
+    std::cout << "Receiving packets. Press Ctrl+C to exit...\n";
+    return true;
+}
+
+void DpdkRxEngine::launch(const WorkerBody &body) {
+    if (use_rss) {
+        launch_on_worker_lcores(nb_workers(), body);
+    } else {
+        body(0);
+    }
+}
+
+void DpdkRxEngine::report(std::ostream &os) const {
+    if (profile) {
+        print_burst_profile(os, "RX", profiles, BURST_SIZE, rte_get_tsc_hz());
+    }
+    capture.report(os);
+}
+
+void DpdkRxEngine::receive(unsigned worker_id, WorkerStats &ws, StreamTable &streams) {
+    CaptureWriter *recorder = capture.worker(worker_id);
+    if (recorder != nullptr && !recorder->start()) {
+        request_stop();
+        return;
+    }
+    if (profile) {
+        receive_loop<true>(worker_id, ws, streams, &profiles[worker_id]);
+    } else {
+        receive_loop<false>(worker_id, ws, streams, nullptr);
+    }
+    if (recorder != nullptr) {
+        recorder->finish();
+    }
+}
+
+// Цикл приёма одной очереди на lcore
+template <bool Profile>
+void DpdkRxEngine::receive_loop(unsigned worker_id, WorkerStats &ws, StreamTable &streams, BurstProfileData *profile_data) {
+    const uint16_t queue_id = worker_id;
+    PollMode mode = poll_mode;
+    if (mode == PollMode::Interrupt &&
+        rte_eth_dev_rx_intr_ctl_q(portid, queue_id, RTE_EPOLL_PER_THREAD, RTE_INTR_EVENT_ADD, nullptr) != 0) {
+        std::cerr << "No RX interrupt for queue " << queue_id << ", idle polls sleep instead" << std::endl;
+        mode = PollMode::Adaptive;
+    }
+    // Ожидание прерывания очереди в epoll, не дольше 100 мс
+    auto wait_for_interrupt = [&] {
+        rte_eth_dev_rx_intr_enable(portid, queue_id);
+        if (rte_eth_rx_queue_count(portid, queue_id) <= 0) {
+            struct rte_epoll_event event;
+            rte_epoll_wait(RTE_EPOLL_PER_THREAD, &event, 1, 100);
+        }
+        rte_eth_dev_rx_intr_disable(portid, queue_id);
+    };
+
+    PollPolicy policy(mode, opts.poll_sleep_us, ws);
+    BurstProfiler<Profile> prof(profile_data);
+    CaptureWriter *recorder = capture.worker(worker_id);
+    while (!stop_requested()) {
         std::array<rte_mbuf*, BURST_SIZE> bufs;
-        uint16_t nb_rx = rte_eth_rx_burst(portid, 0, bufs.data(), BURST_SIZE);
+        prof.skip();
+        uint16_t nb_rx = rte_eth_rx_burst(portid, queue_id, bufs.data(), BURST_SIZE);
+        prof.mark(PHASE_BURST);
+        prof.burst(nb_rx);
 
         if (nb_rx > 0) {
-            global_stats.total_packets += nb_rx;
-            global_stats.packets_second += nb_rx;
+            uint64_t bytes = 0;
+            uint64_t good = 0, good_bytes = 0;
+            std::array<rte_mbuf*, BURST_SIZE> reflected, done;
+            uint16_t nb_reflected = 0, nb_done = 0;
+            uint64_t now_ns = recorder != nullptr ? recorder->now_ns() : 0;
             for (int i = 0; i < nb_rx; i++) {
-                global_stats.total_bytes += bufs[i]->pkt_len;
-                global_stats.bytes_second += bufs[i]->pkt_len;
-                rte_pktmbuf_free(bufs[i]);
+                bytes += bufs[i]->pkt_len;
+                auto *frame = rte_pktmbuf_mtod(bufs[i], uint8_t *);
+                if (recorder != nullptr) {
+                    // Только первый сегмент
+                    recorder->add(frame, rte_pktmbuf_data_len(bufs[i]), bufs[i]->pkt_len, now_ns);
+                }
+                if (streams.record(frame, rte_pktmbuf_data_len(bufs[i]))) {
+                    good++;
+                    good_bytes += bufs[i]->pkt_len;
+                    ws.add_size(bufs[i]->pkt_len);
+                    if (opts.reflect) {
+                        bench_reflect(frame);
+                        reflected[nb_reflected++] = bufs[i];
+                        continue;
+                    }
+                }
+                done[nb_done++] = bufs[i];
             }
-        }
+            ws.add(nb_rx, bytes);
+            ws.add_good(good, good_bytes);
+            prof.mark(PHASE_FRAME);
+
+            // Возврат в пул одним вызовом
+            rte_pktmbuf_free_bulk(done.data(), nb_done);
+            prof.mark(PHASE_FREE);
 
-        if (use_sleep) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Небольшая пауза для снижения нагрузки на CPU
+            if (nb_reflected > 0) {
+                uint16_t nb_tx = rte_eth_tx_burst(portid, queue_id, reflected.data(), nb_reflected);
+                prof.mark(PHASE_BURST);
+                if (nb_tx < nb_reflected) {
+                    rte_pktmbuf_free_bulk(&reflected[nb_tx], nb_reflected - nb_tx);
+                    prof.mark(PHASE_FREE);
+                }
+            }
         }
-    }
-}
 
-void stats_thread() {
-    while (!force_quit) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        print_stats();
+        policy.after_poll(nb_rx, wait_for_interrupt);
     }
+    policy.finish();
+    prof.finish();
 }
 
 int main(int argc, char *argv[]) {
@@ -158,38 +310,21 @@ int main(int argc, char *argv[]) {
     if (ret < 0)
         rte_exit(EXIT_FAILURE, "Error with EAL initialization\n");
 
+    Options opts;
+    parse_options(argc, argv, &opts);
+
+    bool use_rss = false;
+    bool profile = false;
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
-        if (arg == "--no-sleep") {
-            use_sleep = false;
+        if (arg == "--rss") {
+            use_rss = true;
+        }
+        if (arg == "--profile") {
+            profile = true;
         }
     }
 
-    auto mbuf_pool = rte_pktmbuf_pool_create("MBUF_POOL", NUM_MBUFS,
-        MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
-
-    if (mbuf_pool == nullptr)
-        rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
-
-    constexpr uint16_t portid = 0;
-    if (port_init(portid, mbuf_pool) != 0)
-        rte_exit(EXIT_FAILURE, "Cannot init port %" PRIu16 "\n", portid);
-
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
-
-    std::cout << "Receiving packets. Press Ctrl+C to exit...\n";
-
-    std::thread receiver(receive_packets, portid);
-    std::thread stats(stats_thread);
-
-    receiver.join();
-    stats.join();
-
-    std::cout << "\nReceiver stopped." << std::endl;
-
-    std::cout << "Total messages: " << global_stats.total_packets << std::endl;
-    std::cout << "Total bytes: " << global_stats.total_bytes << " bytes" << std::endl;
-
-    return 0;
+    DpdkRxEngine engine(opts, use_rss, profile);
+    return run_engine(engine, opts);
 }
@@ -1,75 +1,66 @@
 #include <iostream>
 #include <iomanip>
 #include <cstring>
-#include <string> 
+#include <string>
 #include <thread>
-#include <atomic>
-#include <csignal>
+#include <chrono>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <unistd.h>
+#include <rte_dev.h>
 #include <rte_eal.h>
+#include <rte_errno.h>
 #include <rte_ethdev.h>
 #include <rte_mbuf.h>
-#include <chrono>
-#include <array>
+#include <rte_lcore.h>
+#include <rte_launch.h>
+#include <rte_memory.h>
+#include <rte_mempool.h>
+#include <rte_cycles.h>
+
+#include "bench_proto.h"
+#include "burst_profile.h"
+#include "dpdk_counters.h"
+#include "dpdk_launch.h"
+#include "engine.h"
+#include "frame.h"
+#include "latency_histogram.h"
+#include "options.h"
+#include "pcap_file.h"
+#include "runner.h"
+#include "size_schedule.h"
+#include "token_bucket.h"
 
 constexpr uint16_t RX_RING_SIZE = 1024;
 constexpr uint16_t TX_RING_SIZE = 1024;
 constexpr uint16_t NUM_MBUFS = 4096;
 constexpr uint16_t MBUF_CACHE_SIZE = 128;
 constexpr uint16_t BURST_SIZE = 32;
-static uint16_t message_size = 128;
-static bool use_sleep = true;
-
-struct Stats {
-    std::atomic<uint64_t> total_packets{0};
-    std::atomic<uint64_t> total_bytes{0};
-    std::atomic<uint64_t> bytes_second{0};
-    std::atomic<uint64_t> packets_second{0};
-    std::chrono::steady_clock::time_point start_time;
-};
-
-static struct Stats global_stats;
-static std::atomic<bool> force_quit{false};;
 
-std::string format_unit(double value) {
-    const std::array<std::string, 5> units = {"", "K", "M", "G", "T"};
-    int i = 0;
-    while (value >= 1000.0 && i < 4) {
-        value /= 1000.0;
-        i++;
-    }
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2) << value << " " << units[i];
-    return oss.str();
-}
+// Template: кадр записывается в mbuf один раз; Legacy: заполнение каждого пакета
+enum class TxPath { Template, Legacy };
 
-void print_stats() {
-    std::cout << "\rStats: " 
-              << format_unit(global_stats.total_packets.load()) << "-packets, "
-              << format_unit(global_stats.total_bytes.load()) << "bytes, "
-              << format_unit(global_stats.packets_second.load()) << "-packets/s, "
-              << format_unit(global_stats.bytes_second.load()) << "b/s   " << std::flush;
-    
-    global_stats.packets_second = 0;
-    global_stats.bytes_second = 0;
-}
+// --replay в режиме IOVA как VA: кадры прикрепляются к mbuf прямо из файла
+struct alignas(RTE_CACHE_LINE_SIZE) ReplayExtBuf {
+    rte_mbuf_ext_shared_info shinfo;
+};
 
-void signal_handler(int signum) {
-    if (signum == SIGINT || signum == SIGTERM) {
-        std::cout << "\nSignal " << signum << " received, preparing to exit..." << std::endl;
-        force_quit = true;
-    }
-}
+void replay_extbuf_free(void * /*addr*/, void * /*opaque*/) {}
 
-void stats_thread() {
-    while (!force_quit) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        print_stats();
-    }
-}
+// Контекст очереди TX, на отдельной кэш-линии
+struct alignas(RTE_CACHE_LINE_SIZE) TxQueueConf {
+    uint16_t portid;
+    uint16_t queue_id;
+    rte_mempool *mbuf_pool;
+    WorkerStats *stats;
+    uint64_t seq;
+};
 
-int port_init(uint16_t port, rte_mempool* mbuf_pool) {
+int port_init(uint16_t port, rte_mempool* mbuf_pool, uint16_t tx_rings) {
     struct rte_eth_conf port_conf_default = {};
-    const uint16_t rx_rings = 1, tx_rings = 1;
+    const uint16_t rx_rings = 1;
     uint16_t nb_rxd = RX_RING_SIZE;
     uint16_t nb_txd = TX_RING_SIZE;
 
@@ -79,6 +70,11 @@ int port_init(uint16_t port, rte_mempool* mbuf_pool) {
     int retval = rte_eth_dev_info_get(port, &dev_info);
     if (retval != 0) return retval;
 
+    if (tx_rings > dev_info.max_tx_queues) {
+        std::cerr << "Port " << port << " supports only " << dev_info.max_tx_queues << " TX queues" << std::endl;
+        return -EINVAL;
+    }
+
     retval = rte_eth_dev_configure(port, rx_rings, tx_rings, &port_conf_default);
     if (retval != 0) return retval;
 
@@ -121,87 +117,444 @@ int port_init(uint16_t port, rte_mempool* mbuf_pool) {
     return 0;
 }
 
-int main(int argc, char *argv[]) {
-    int ret = rte_eal_init(argc, argv);
-    if (ret < 0) rte_exit(EXIT_FAILURE, "Error with EAL initialization\n");
+// Копирование готового кадра в mbuf (для rte_mempool_obj_iter)
+void init_tx_frame(rte_mempool * /*mp*/, void *opaque, void *obj, unsigned /*obj_idx*/) {
+    auto *frame = static_cast<const std::vector<uint8_t> *>(opaque);
+    auto *mbuf = static_cast<rte_mbuf *>(obj);
+    std::memcpy(static_cast<char *>(mbuf->buf_addr) + RTE_PKTMBUF_HEADROOM, frame->data(), frame->size());
+}
 
-    std::string mac_str = "08:00:27:56:59:dd";
-    for (int i = 1; i < argc; i++) {
-        std::string arg = argv[i];
-        if (arg == "--size" && i + 1 < argc) {
-            message_size = std::stoi(argv[++i]);
-        }
-        if (arg == "--no-sleep") {
-            use_sleep = false;
+// Отправка через DPDK: очередь TX на каждый lcore с --multi-queue
+class DpdkTxEngine : public TxEngine {
+public:
+    DpdkTxEngine(const Options &opts, bool multi_queue, TxPath tx_path, bool profile)
+        : opts(opts), multi_queue(multi_queue), tx_path(tx_path), profile(profile) {}
+
+    bool setup() override;
+    unsigned nb_workers() const override { return queues.size(); }
+    void transmit(unsigned worker_id, WorkerStats &stats) override;
+    void launch(const WorkerBody &body) override;
+    void report(std::ostream &os) const override;
+    void device_counters(DeviceCounters *counters) override { port_counters.read(counters); }
+
+private:
+    const Options &opts;
+    bool multi_queue;
+    TxPath tx_path;
+    bool profile;
+    uint16_t portid = 0;
+    SizeSchedule sizes;
+    FlowTable flows;
+    std::vector<TxQueueConf> queues;
+    LatencyHistogram rtt_histogram;
+    DpdkPortCounters port_counters;
+    std::vector<BurstProfileData> profiles;  // по одному на очередь с --profile
+    PcapFile pcap;
+    bool replay_zero_copy = false;  // IOVA как VA: без копирования
+    uint16_t replay_max_len = 0;
+    std::vector<ReplayExtBuf> replay_bufs;  // по одному на очередь с --replay
+
+    bool setup_replay();
+    uint16_t next_burst(TokenBucket &pacer, double cost) const;
+    void poll_reflected(uint16_t port);
+    template <bool Profile> void tx_template(TxQueueConf *conf, BurstProfileData *profile_data);
+    template <bool Profile> void tx_legacy(TxQueueConf *conf, BurstProfileData *profile_data);
+    template <bool Profile> void tx_replay(TxQueueConf *conf, BurstProfileData *profile_data);
+};
+
+bool DpdkTxEngine::setup() {
+    // Каждый кадр вмещает заголовок теста и помещается в mbuf
+    if (!SizeSchedule::build(opts, 0, BENCH_MIN_FRAME, RTE_MBUF_DEFAULT_DATAROOM, &sizes)) return false;
+
+    // Очередь TX на каждый рабочий lcore или одна на главном
+    uint16_t nb_queues = 1;
+    if (multi_queue) {
+        nb_queues = rte_lcore_count() - 1;
+        if (nb_queues == 0) rte_exit(EXIT_FAILURE, "--multi-queue needs at least one worker lcore (e.g. -l 0-3)\n");
+    }
+
+    // Каждой очереди хватает на кольцо TX, пакет и кэш lcore
+    unsigned nb_mbufs = std::max<unsigned>(NUM_MBUFS, nb_queues * (TX_RING_SIZE + BURST_SIZE + MBUF_CACHE_SIZE) + RX_RING_SIZE);
+    struct rte_mempool *mbuf_pool = rte_pktmbuf_pool_create("MBUF_POOL", nb_mbufs, MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+    if (mbuf_pool == nullptr) rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
+
+    if (port_init(portid, mbuf_pool, nb_queues) != 0) rte_exit(EXIT_FAILURE, "Cannot init port %" PRIu16 "\n", portid);
+    port_counters.init(portid);
+
+    rte_ether_addr src_mac;
+    rte_eth_macaddr_get(portid, &src_mac);
+    flows = FlowTable(src_mac.addr_bytes, opts.dst_mac.data(), opts.flows);
+
+    // Для template отдельный пул, чтобы приём не перезаписал кадры
+    struct rte_mempool *tx_pool = mbuf_pool;
+    if (!opts.replay.empty()) {
+        if (!setup_replay()) return false;
+        // Без копирования: в mbuf только заголовки; кадр с VLAN на 4 байта длиннее MTU
+        uint16_t data_room = replay_zero_copy ? 0 : std::max<uint16_t>(RTE_MBUF_DEFAULT_BUF_SIZE, RTE_PKTMBUF_HEADROOM + replay_max_len + RTE_VLAN_HLEN);
+        tx_pool = rte_pktmbuf_pool_create("REPLAY_POOL", nb_mbufs, MBUF_CACHE_SIZE, 0, data_room, rte_socket_id());
+        if (tx_pool == nullptr) rte_exit(EXIT_FAILURE, "Cannot create replay mbuf pool\n");
+        replay_bufs.resize(nb_queues);
+        for (ReplayExtBuf &b : replay_bufs) {
+            b.shinfo.free_cb = replay_extbuf_free;
+            b.shinfo.fcb_opaque = nullptr;
+            rte_mbuf_ext_refcnt_set(&b.shinfo, 1);
         }
-        if (arg == "--dst" && i + 1 < argc) {
-            mac_str = argv[++i];
+    } else if (tx_path == TxPath::Template) {
+        tx_pool = rte_pktmbuf_pool_create("TX_POOL", nb_mbufs, MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
+        if (tx_pool == nullptr) rte_exit(EXIT_FAILURE, "Cannot create TX mbuf pool\n");
+        std::vector<uint8_t> frame = build_bench_frame(flows, sizes.max(), 0);
+        rte_mempool_obj_iter(tx_pool, init_tx_frame, &frame);
+    }
+
+    // Статистика привязывается в transmit()
+    queues.resize(nb_queues);
+    for (uint16_t q = 0; q < nb_queues; q++) {
+        queues[q] = TxQueueConf{portid, q, tx_pool, nullptr, 0};
+    }
+    if (profile) {
+        profiles.resize(nb_queues);
+    }
+    return true;
+}
+
+// Открытие записи; в режиме IOVA как VA регистрация памяти для DMA
+bool DpdkTxEngine::setup_replay() {
+    uint16_t mtu = RTE_ETHER_MTU;
+    rte_eth_dev_get_mtu(portid, &mtu);
+    replay_max_len = RTE_ETHER_HDR_LEN + mtu;
+    replay_zero_copy = rte_eal_iova_mode() == RTE_IOVA_VA;
+    if (!pcap.open(opts.replay, replay_max_len, replay_zero_copy)) return false;
+    if (!replay_zero_copy) {
+        std::cout << "IOVA as PA: replayed frames are copied into mbufs" << std::endl;
+        return true;
+    }
+
+    void *base = const_cast<uint8_t *>(pcap.map_base());
+    size_t len = pcap.map_length();
+    size_t page = sysconf(_SC_PAGESIZE);
+    std::vector<rte_iova_t> iovas;
+    for (size_t off = 0; off < len; off += page) {
+        iovas.push_back(reinterpret_cast<uintptr_t>(base) + off);
+    }
+    if (rte_extmem_register(base, len, iovas.data(), iovas.size(), page) != 0) {
+        std::cerr << "Cannot register the capture with DPDK: " << rte_strerror(rte_errno) << std::endl;
+        return false;
+    }
+
+    // ENOTSUP: у шины нет своего DMA (виртуальные устройства)
+    struct rte_eth_dev_info dev_info;
+    if (rte_eth_dev_info_get(portid, &dev_info) != 0 ||
+        (rte_dev_dma_map(dev_info.device, base, reinterpret_cast<uintptr_t>(base), len) != 0 && rte_errno != ENOTSUP)) {
+        std::cerr << "DMA mapping of the capture failed: " << rte_strerror(rte_errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Цикл отправки одной очереди
+void DpdkTxEngine::transmit(unsigned worker_id, WorkerStats &stats) {
+    TxQueueConf *conf = &queues[worker_id];
+    conf->stats = &stats;
+    if (!opts.replay.empty()) {
+        profile ? tx_replay<true>(conf, &profiles[worker_id]) : tx_replay<false>(conf, nullptr);
+    } else if (tx_path == TxPath::Template) {
+        profile ? tx_template<true>(conf, &profiles[worker_id]) : tx_template<false>(conf, nullptr);
+    } else {
+        profile ? tx_legacy<true>(conf, &profiles[worker_id]) : tx_legacy<false>(conf, nullptr);
+    }
+}
+
+void DpdkTxEngine::launch(const WorkerBody &body) {
+    if (multi_queue) {
+        launch_on_worker_lcores(nb_workers(), body);
+    } else {
+        body(0);
+    }
+}
+
+void DpdkTxEngine::report(std::ostream &os) const {
+    if (opts.latency) {
+        print_latency_report(os, rtt_histogram);
+    }
+    if (profile) {
+        print_burst_profile(os, "TX", profiles, BURST_SIZE, rte_get_tsc_hz());
+    }
+}
+
+// Приём отражённых кадров с очереди 0 и замер RTT
+void DpdkTxEngine::poll_reflected(uint16_t port) {
+    std::array<rte_mbuf*, BURST_SIZE> bufs;
+    uint16_t nb_rx = rte_eth_rx_burst(port, 0, bufs.data(), BURST_SIZE);
+    if (nb_rx == 0) {
+        return;
+    }
+
+    uint64_t now = rte_rdtsc();
+    double ns_per_cycle = 1e9 / rte_get_tsc_hz();
+    for (uint16_t i = 0; i < nb_rx; i++) {
+        auto *frame = rte_pktmbuf_mtod(bufs[i], uint8_t *);
+        uint16_t stream_id, flags;
+        uint64_t seq;
+        if (bench_header_parse(frame, rte_pktmbuf_data_len(bufs[i]), &stream_id, &seq, &flags) && (flags & BENCH_FLAG_REFLECTED)) {
+            rtt_histogram.record(static_cast<uint64_t>((now - bench_header_timestamp(frame)) * ns_per_cycle));
         }
     }
+    rte_pktmbuf_free_bulk(bufs.data(), nb_rx);
+}
 
-    uint16_t portid = 0;
+// Размер следующего пакета с учётом ограничения скорости
+uint16_t DpdkTxEngine::next_burst(TokenBucket &pacer, double cost) const {
+    if (!pacer.enabled()) {
+        return BURST_SIZE;
+    }
+    return pacer.wait([] { return rte_rdtsc(); }, cost, BURST_SIZE, stop_requested);
+}
 
-    struct rte_mempool *mbuf_pool = rte_pktmbuf_pool_create("MBUF_POOL", NUM_MBUFS, MBUF_CACHE_SIZE, 0, RTE_MBUF_DEFAULT_BUF_SIZE, rte_socket_id());
-    if (mbuf_pool == nullptr) rte_exit(EXIT_FAILURE, "Cannot create mbuf pool\n");
+template <bool Profile>
+void DpdkTxEngine::tx_template(TxQueueConf *conf, BurstProfileData *profile_data) {
+    SizeSchedule::Cursor frame_sizes = sizes.cursor(conf->queue_id, nb_workers());
+    unsigned flow = conf->queue_id % flows.size();
+    double cost;
+    TokenBucket pacer = make_pacer(opts.rate_pps, opts.rate_bps, nb_workers(), sizes.mean(), BURST_SIZE, rte_get_tsc_hz(), &cost);
+    BurstProfiler<Profile> prof(profile_data);
 
-    if (port_init(portid, mbuf_pool) != 0) rte_exit(EXIT_FAILURE, "Cannot init port %" PRIu16 "\n", portid);
+    while (!stop_requested()) {
+        std::array<rte_mbuf*, BURST_SIZE> bufs;
 
-    rte_ether_addr dst_mac;
-    rte_ether_addr src_mac;
+        uint16_t nb = next_burst(pacer, cost);
+        prof.skip();
+        if (nb == 0 || rte_pktmbuf_alloc_bulk(conf->mbuf_pool, bufs.data(), nb) != 0) {
+            continue;  // весь пул в кольцах TX, ждём завершения
+        }
+        prof.mark(PHASE_ALLOC);
+
+        // Длины сохраняются: после передачи mbuf принадлежат драйверу
+        std::array<uint16_t, BURST_SIZE> lens;
+        for (uint16_t i = 0; i < nb; i++) {
+            rte_mbuf *buf = bufs[i];
+            auto *frame = rte_pktmbuf_mtod(buf, uint8_t *);
+            lens[i] = frame_sizes.next();
+            buf->data_len = lens[i];
+            buf->pkt_len = lens[i];
+            // Пул общий, поэтому stream id тоже перезаписывается
+            bench_header_write(frame, conf->queue_id, conf->seq++);
+            if (opts.latency) {
+                bench_header_set_timestamp(frame, rte_rdtsc());
+            }
+            flows.write_headers(frame, flow, lens[i]);
+            flow = flows.next(flow);
+        }
+        prof.mark(PHASE_FRAME);
 
-    sscanf(mac_str.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
-        &dst_mac.addr_bytes[0], &dst_mac.addr_bytes[1], &dst_mac.addr_bytes[2],
-        &dst_mac.addr_bytes[3], &dst_mac.addr_bytes[4], &dst_mac.addr_bytes[5]);
+        uint16_t nb_tx = rte_eth_tx_burst(conf->portid, conf->queue_id, bufs.data(), nb);
+        prof.mark(PHASE_BURST);
+        prof.burst(nb_tx);
+        uint64_t bytes = std::accumulate(lens.begin(), lens.begin() + nb_tx, uint64_t{0});
+        if (nb_tx) {
+            conf->stats->add(nb_tx, bytes);
+        }
+        pacer.consume_sent(nb_tx, bytes);
+
+        if (nb_tx < nb) {
+            // Неотправленные отбрасываются, их номера используются снова
+            conf->seq -= nb - nb_tx;
+            prof.skip();
+            rte_pktmbuf_free_bulk(&bufs[nb_tx], nb - nb_tx);
+            prof.mark(PHASE_FREE);
+            conf->stats->add_drops(nb - nb_tx);
+        }
 
-    rte_eth_macaddr_get(portid, &src_mac);
+        if (opts.latency && conf->queue_id == 0) {
+            poll_reflected(conf->portid);
+        }
 
-    std::signal(SIGINT, signal_handler);
-    std::signal(SIGTERM, signal_handler);
+        if (opts.use_sleep) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Simulate processing time
+        }
+    }
+    prof.finish();
+}
 
-    std::thread stats(stats_thread);
+template <bool Profile>
+void DpdkTxEngine::tx_legacy(TxQueueConf *conf, BurstProfileData *profile_data) {
+    SizeSchedule::Cursor frame_sizes = sizes.cursor(conf->queue_id, nb_workers());
+    unsigned flow = conf->queue_id % flows.size();
+    double cost;
+    TokenBucket pacer = make_pacer(opts.rate_pps, opts.rate_bps, nb_workers(), sizes.mean(), BURST_SIZE, rte_get_tsc_hz(), &cost);
+    BurstProfiler<Profile> prof(profile_data);
 
-    while (!force_quit) {
+    while (!stop_requested()) {
         std::array<rte_mbuf*, BURST_SIZE> bufs;
+        std::array<uint16_t, BURST_SIZE> lens;
 
-        for (auto& buf : bufs) {
-            buf = rte_pktmbuf_alloc(mbuf_pool);
+        uint16_t nb = next_burst(pacer, cost);
+        prof.skip();
+        for (uint16_t i = 0; i < nb; i++) {
+            rte_mbuf *&buf = bufs[i];
+            buf = rte_pktmbuf_alloc(conf->mbuf_pool);
             if (buf == nullptr) {
-                rte_exit(EXIT_FAILURE, "Failed to allocate mbuf\n");
+                // Пул пуст: остаток пачки отправляется в следующей итерации
+                conf->stats->add_drops(nb - i);
+                nb = i;
+                break;
             }
-            auto *packet_data = rte_pktmbuf_mtod(buf, rte_ether_hdr*);
-            rte_ether_addr_copy(&dst_mac, &packet_data->dst_addr);
-            rte_ether_addr_copy(&src_mac, &packet_data->src_addr);
-            packet_data->ether_type = rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4);
-
-            auto payload = reinterpret_cast<char*>(packet_data + 1);
-            std::memset(payload, 'A', message_size - sizeof(rte_ether_hdr));
+            prof.mark(PHASE_ALLOC);
+            lens[i] = frame_sizes.next();
+            auto *packet_data = rte_pktmbuf_mtod(buf, uint8_t *);
+            std::memset(packet_data + BENCH_HEADER_OFFSET, 'A', lens[i] - BENCH_HEADER_OFFSET);
+            bench_header_write(packet_data, conf->queue_id, conf->seq++);
+            if (opts.latency) {
+                bench_header_set_timestamp(packet_data, rte_rdtsc());
+            }
+            // Заголовки Ethernet, IPv4 и UDP с контрольными суммами
+            flows.write_headers(packet_data, flow, lens[i]);
+            flow = flows.next(flow);
 
-            buf->data_len = message_size;
-            buf->pkt_len = message_size;
+            buf->data_len = lens[i];
+            buf->pkt_len = lens[i];
+            prof.mark(PHASE_FRAME);
         }
 
-        uint16_t nb_tx = rte_eth_tx_burst(portid, 0, bufs.data(), BURST_SIZE);
+        uint16_t nb_tx = rte_eth_tx_burst(conf->portid, conf->queue_id, bufs.data(), nb);
+        prof.mark(PHASE_BURST);
+        prof.burst(nb_tx);
+        uint64_t bytes = std::accumulate(lens.begin(), lens.begin() + nb_tx, uint64_t{0});
         if (nb_tx) {
-            global_stats.total_packets += nb_tx;
-            global_stats.total_bytes += nb_tx * message_size;
-            global_stats.packets_second += nb_tx;
-            global_stats.bytes_second += nb_tx * message_size;
+            conf->stats->add(nb_tx, bytes);
         }
+        pacer.consume_sent(nb_tx, bytes);
+        conf->seq -= nb - nb_tx;
+        conf->stats->add_drops(nb - nb_tx);
 
-        for (uint16_t buf = nb_tx; buf < BURST_SIZE; buf++)
+        prof.skip();
+        for (uint16_t buf = nb_tx; buf < nb; buf++)
                 rte_pktmbuf_free(bufs[buf]);
+        prof.mark(PHASE_FREE);
+
+        if (opts.latency && conf->queue_id == 0) {
+            poll_reflected(conf->portid);
+        }
 
-        if (use_sleep) {
+        if (opts.use_sleep) {
             std::this_thread::sleep_for(std::chrono::milliseconds(1));  // Simulate processing time
         }
     }
+    prof.finish();
+}
 
-    stats.join();
-    std::cout << std::endl;
-    std::cout << "Sender stopped by user." << std::endl;
+// Воспроизведение записи; неотправленные кадры повторяются
+template <bool Profile>
+void DpdkTxEngine::tx_replay(TxQueueConf *conf, BurstProfileData *profile_data) {
+    ReplayCursor cursor(pcap, conf->queue_id, nb_workers(), opts.replay_speed, opts.replay_loops, rte_get_tsc_hz());
+    rte_mbuf_ext_shared_info *shinfo = &replay_bufs[conf->queue_id].shinfo;
+    double cost;
+    TokenBucket pacer = make_pacer(opts.rate_pps, opts.rate_bps, nb_workers(), pcap.mean_len(), BURST_SIZE, rte_get_tsc_hz(), &cost);
+    BurstProfiler<Profile> prof(profile_data);
+
+    while (!stop_requested()) {
+        std::array<const PcapRecord *, BURST_SIZE> frames;
+        std::array<rte_mbuf*, BURST_SIZE> bufs;
 
-    std::cout << "Total messages: " << global_stats.total_packets << std::endl;
-    std::cout << "Total bytes: " << global_stats.total_bytes << " bytes" << std::endl;
+        uint16_t nb = next_burst(pacer, cost);
+        if (nb == 0) {
+            continue;
+        }
+        nb = cursor.next(frames.data(), nb);
+        if (nb == 0) {
+            break;  // все проходы отправлены
+        }
+        prof.skip();
+        if (rte_pktmbuf_alloc_bulk(conf->mbuf_pool, bufs.data(), nb) != 0) {
+            cursor.unget(nb);
+            continue;  // весь пул в кольцах TX, ждём завершения
+        }
+        prof.mark(PHASE_ALLOC);
 
-    return 0;
-}
\ No newline at end of file
+        // Один refcount на пакет, драйвер уменьшает его на каждом mbuf
+        if (replay_zero_copy) {
+            rte_mbuf_ext_refcnt_update(shinfo, nb);
+        }
+        uint64_t bytes = 0;
+        uint16_t filled = 0;
+        for (uint16_t i = 0; i < nb; i++, filled++) {
+            rte_mbuf *buf = bufs[i];
+            uint8_t *data = const_cast<uint8_t *>(pcap.data(*frames[i]));
+            uint16_t len = frames[i]->len;
+            if (replay_zero_copy) {
+                rte_pktmbuf_attach_extbuf(buf, data, reinterpret_cast<uintptr_t>(data), len, shinfo);
+                buf->data_len = len;
+                buf->pkt_len = len;
+            } else {
+                char *dst = rte_pktmbuf_append(buf, len);
+                if (dst == nullptr) {
+                    break;
+                }
+                std::memcpy(dst, data, len);
+            }
+            bytes += len;
+        }
+        if (filled < nb) {
+            std::cerr << "Replayed frame of " << frames[filled]->len << " bytes does not fit an mbuf" << std::endl;
+            rte_pktmbuf_free_bulk(bufs.data(), nb);
+            request_stop();
+            break;
+        }
+        prof.mark(PHASE_FRAME);
+
+        uint16_t nb_tx = rte_eth_tx_burst(conf->portid, conf->queue_id, bufs.data(), nb);
+        prof.mark(PHASE_BURST);
+        prof.burst(nb_tx);
+        if (nb_tx < nb) {
+            for (uint16_t i = nb_tx; i < nb; i++) {
+                bytes -= frames[i]->len;
+            }
+            prof.skip();
+            rte_pktmbuf_free_bulk(&bufs[nb_tx], nb - nb_tx);
+            prof.mark(PHASE_FREE);
+            cursor.unget(nb - nb_tx);
+        }
+        pacer.consume_sent(nb_tx, bytes);
+        if (nb_tx) {
+            conf->stats->add(nb_tx, bytes);
+        }
+
+        if (opts.latency && conf->queue_id == 0) {
+            poll_reflected(conf->portid);
+        }
+    }
+    prof.finish();
+}
+
+int main(int argc, char *argv[]) {
+    int ret = rte_eal_init(argc, argv);
+    if (ret < 0) rte_exit(EXIT_FAILURE, "Error with EAL initialization\n");
+
+    Options opts;
+    opts.size = 128;
+    opts.dst_mac = {0x08, 0x00, 0x27, 0x56, 0x59, 0xdd};
+    parse_options(argc, argv, &opts);
+
+    bool multi_queue = false;
+    bool profile = false;
+    TxPath tx_path = TxPath::Template;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--multi-queue") {
+            multi_queue = true;
+        }
+        if (arg == "--profile") {
+            profile = true;
+        }
+        if (arg == "--tx-path" && i + 1 < argc) {
+            std::string path = argv[++i];
+            if (path == "legacy") {
+                tx_path = TxPath::Legacy;
+            } else if (path != "template") {
+                rte_exit(EXIT_FAILURE, "Unknown TX path: %s (expected template or legacy)\n", path.c_str());
+            }
+        }
+    }
+
+    DpdkTxEngine engine(opts, multi_queue, tx_path, profile);
+    return run_engine(engine, opts);
+}
@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+# Неинтерактивный бенчмарк на одной машине без виртуальных машин и SSH.
+#
+# Сокеты и AF_XDP: пара veth между двумя сетевыми пространствами имен
+# (отправитель в nb-tx, приемник в nb-rx). DPDK: виртуальные устройства
+# net_af_packet поверх той же пары veth или пара net_memif через unix-сокет.
+# Перебираются размер пакета x число потоков x движок, результаты собираются
+# из --output json каждой утилиты и выводятся таблицей.
+#
+# Пример (из каталога с собранными утилитами):
+#   sudo python3 local_benchmark.py --build-dir build --sizes 64,1024 --threads 1,2 \
+#       --engines sendto,tx-ring,mmsg,io-uring,xdp,dpdk-af-packet --out matrix.csv
+
+import argparse
+import csv
+import json
+import os
+import signal
+import subprocess
+import sys
+import tempfile
+import time
+
+TX_NS = 'nb-tx'
+RX_NS = 'nb-rx'
+TX_IF = 'nbv0'
+RX_IF = 'nbv1'
+
+# Движок -> (отправитель, аргументы отправителя, приемник, аргументы приемника)
+SOCKET_ENGINES = {
+    'sendto':   ('socket_mt', ['--mode', 'sendto'],   'socket_receiver', ['--mode', 'recvfrom']),
+    'tx-ring':  ('socket_mt', ['--mode', 'tx-ring'],  'socket_receiver', ['--mode', 'rx-ring']),
+    'mmsg':     ('socket_mt', ['--mode', 'mmsg'],     'socket_receiver', ['--mode', 'mmsg']),
+    'io-uring': ('socket_mt', ['--mode', 'io-uring'], 'socket_receiver', ['--mode', 'io-uring']),
+}
+XDP_ENGINES = {
+    # veth поддерживает только копирующий режим AF_XDP
+    'xdp': ('xdp_sender', ['--bind', 'copy'], 'xdp_receiver', ['--bind', 'copy']),
+}
+# net_ring работает только внутри одного процесса, поэтому для пары
+# отправитель/приемник используются net_af_packet и net_memif
+DPDK_ENGINES = ['dpdk-af-packet', 'dpdk-memif']
+ALL_ENGINES = list(SOCKET_ENGINES) + list(XDP_ENGINES) + DPDK_ENGINES
+
+
+def run(cmd, check=True):
+    return subprocess.run(cmd, check=check, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+
+
+def ns_exec(ns, cmd):
+    return ['ip', 'netns', 'exec', ns] + cmd
+
+
+# Создание пары veth между двумя пространствами имен
+def setup_netns():
+    teardown_netns()
+    run(['ip', 'netns', 'add', TX_NS])
+    run(['ip', 'netns', 'add', RX_NS])
+    run(['ip', 'link', 'add', TX_IF, 'netns', TX_NS, 'type', 'veth', 'peer', 'name', RX_IF, 'netns', RX_NS])
+    for ns, iface in ((TX_NS, TX_IF), (RX_NS, RX_IF)):
+        run(['ip', '-n', ns, 'link', 'set', 'lo', 'up'])
+        run(['ip', '-n', ns, 'link', 'set', iface, 'up'])
+
+
+def teardown_netns():
+    for ns in (TX_NS, RX_NS):
+        run(['ip', 'netns', 'del', ns], check=False)
+
+
+def mac_address(ns, iface):
+    out = run(['ip', '-n', ns, '-j', 'link', 'show', iface]).stdout
+    return json.loads(out)[0]['address']
+
+
+# Итог прогона и секундные скорости процесса; интервалы без трафика (разогрев
+# приемника и хвост после остановки отправителя) в скорости не попадают
+def read_results(path):
+    summary, pps, bps = None, [], []
+    try:
+        with open(path) as f:
+            for line in f:
+                record = json.loads(line)
+                if record.get('type') == 'summary':
+                    summary = record
+                elif record.get('type') == 'sample' and record.get('worker') == 'all' and record['packets'] > 0:
+                    pps.append(record['pps'])
+                    bps.append(record['bps'])
+    except (OSError, ValueError):
+        return None
+    if summary is None:
+        return None
+    summary['active_pps'] = pps
+    summary['active_bps'] = bps
+    return summary
+
+
+def mean(values):
+    return sum(values) / len(values) if values else 0.0
+
+
+def median(values):
+    values = sorted(values)
+    return values[(len(values) - 1) // 2] if values else 0.0
+
+
+# Команды отправителя и приемника для одного прогона
+def build_commands(args, engine, size, threads, workdir):
+    rx_mac = mac_address(RX_NS, RX_IF)
+    tx_out = os.path.join(workdir, 'tx.json')
+    rx_out = os.path.join(workdir, 'rx.json')
+    common_tx = ['--size', str(size), '--dst', rx_mac, '--output', 'json', '--output-file', tx_out]
+    if args.rate_pps:
+        common_tx += ['--rate-pps', str(args.rate_pps)]
+    else:
+        common_tx += ['--no-sleep']
+    common_rx = ['--output', 'json', '--output-file', rx_out]
+    if args.rx_poll:
+        common_rx += ['--poll', args.rx_poll]
+    binary = lambda name: os.path.join(args.build_dir, name)
+
+    if engine in SOCKET_ENGINES or engine in XDP_ENGINES:
+        sender, tx_args, receiver, rx_args = {**SOCKET_ENGINES, **XDP_ENGINES}[engine]
+        tx_cmd = [binary(sender), '--iface', TX_IF] + tx_args + common_tx
+        rx_cmd = [binary(receiver), '--iface', RX_IF] + rx_args + common_rx
+        if engine in SOCKET_ENGINES:
+            tx_cmd += ['--j', str(threads)]
+            rx_cmd += ['--j', str(threads)]
+        return ns_exec(TX_NS, tx_cmd), ns_exec(RX_NS, rx_cmd), tx_out, rx_out
+
+    # DPDK: --size задает весь кадр, а не полезную нагрузку
+    dpdk_size = ['--size', str(size + 14)]
+    lcores = '0-%d' % threads if threads > 1 else '0'
+    eal = ['--no-pci', '--in-memory']
+    if engine == 'dpdk-af-packet':
+        tx_vdev = 'net_af_packet0,iface=%s,qpairs=%d' % (TX_IF, threads)
+        rx_vdev = 'net_af_packet0,iface=%s' % RX_IF
+        tx_ns, rx_ns = TX_NS, RX_NS
+    else:
+        sock = os.path.join(workdir, 'memif.sock')
+        tx_vdev = 'net_memif0,role=server,socket=%s' % sock
+        rx_vdev = 'net_memif0,role=client,socket=%s' % sock
+        tx_ns = rx_ns = None
+    tx_cmd = [binary('dpdk_sender'), '-l', lcores, '--file-prefix', 'nbtx', '--vdev', tx_vdev] + eal + ['--'] \
+        + common_tx + dpdk_size
+    if threads > 1:
+        tx_cmd.append('--multi-queue')
+    # af_packet и memif не поддерживают RSS, приемник всегда опрашивает одну очередь
+    rx_cmd = [binary('dpdk_receiver'), '-l', '0', '--file-prefix', 'nbrx', '--vdev', rx_vdev] + eal + ['--'] \
+        + common_rx + ['--no-sleep']
+    if tx_ns:
+        tx_cmd, rx_cmd = ns_exec(tx_ns, tx_cmd), ns_exec(rx_ns, rx_cmd)
+    return tx_cmd, rx_cmd, tx_out, rx_out
+
+
+def stop(proc, timeout=5):
+    if proc.poll() is None:
+        proc.send_signal(signal.SIGINT)
+        try:
+            proc.wait(timeout)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+
+
+# Один прогон: приемник запускается первым, отправитель работает --duration секунд
+def run_case(args, engine, size, threads):
+    with tempfile.TemporaryDirectory(prefix='netbench-') as workdir:
+        tx_cmd, rx_cmd, tx_out, rx_out = build_commands(args, engine, size, threads, workdir)
+        log = open(os.path.join(args.log_dir, '%s-%d-%d.log' % (engine, size, threads)), 'w') if args.log_dir \
+            else subprocess.DEVNULL
+        rx = subprocess.Popen(rx_cmd, stdout=log, stderr=log)
+        time.sleep(args.warmup)
+        tx = subprocess.Popen(tx_cmd, stdout=log, stderr=log)
+        time.sleep(args.duration)
+        stop(tx)
+        time.sleep(1)  # кадры в полете доходят до приемника
+        stop(rx)
+        if log is not subprocess.DEVNULL:
+            log.close()
+        return read_results(tx_out), read_results(rx_out)
+
+
+def result_row(engine, size, threads, tx, rx):
+    row = {'engine': engine, 'size': size, 'threads': threads}
+    if tx is None or rx is None:
+        row['status'] = 'failed'
+        return row
+    sent = tx['packets']
+    received = rx['packets']
+    row.update({
+        'status': 'ok',
+        'tx_pps_mean': round(mean(tx['active_pps'])),
+        'tx_pps_p50': round(median(tx['active_pps'])),
+        'rx_pps_mean': round(mean(rx['active_pps'])),
+        'rx_pps_p50': round(median(rx['active_pps'])),
+        'rx_gbps_mean': round(mean(rx['active_bps']) / 1e9, 3),
+        'tx_packets': sent,
+        'rx_packets': received,
+        'rx_drops': rx['drops'],
+        # Потери считаются по счетчикам обеих сторон: при разбиении потока между
+        # потоками приемника (fanout) номера последовательностей завышают потери
+        'loss_pct': round(100.0 * max(sent - received, 0) / sent, 4) if sent else 0.0,
+    })
+    # Доля времени потоков приема на CPU: опрос и pause, без sleep и ожидания в ядре
+    poll_s = rx.get('poll_s')
+    if poll_s and sum(poll_s.values()) > 0:
+        on_cpu = poll_s['busy'] + poll_s['spin'] + poll_s['pause']
+        row['rx_cpu_pct'] = round(100.0 * on_cpu / sum(poll_s.values()), 2)
+    return row
+
+
+COLUMNS = ['engine', 'size', 'threads', 'status', 'tx_pps_mean', 'tx_pps_p50', 'rx_pps_mean', 'rx_pps_p50',
+           'rx_gbps_mean', 'rx_cpu_pct', 'tx_packets', 'rx_packets', 'rx_drops', 'loss_pct']
+
+
+def print_matrix(rows):
+    widths = {c: max(len(c), *(len(str(r.get(c, ''))) for r in rows)) for c in COLUMNS}
+    print(' '.join(c.rjust(widths[c]) for c in COLUMNS))
+    for r in rows:
+        print(' '.join(str(r.get(c, '')).rjust(widths[c]) for c in COLUMNS))
+
+
+def parse_list(value, cast=str):
+    return [cast(v) for v in value.split(',') if v]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Local veth/netns benchmark sweep')
+    parser.add_argument('--build-dir', default='build', help='directory with the built binaries')
+    parser.add_argument('--engines', default='sendto,tx-ring,mmsg,io-uring,xdp',
+                        help='comma separated subset of: ' + ','.join(ALL_ENGINES))
+    parser.add_argument('--sizes', default='64,512,1400', help='payload sizes in bytes')
+    parser.add_argument('--threads', default='1,2', help='sender/receiver thread (or TX queue) counts')
+    parser.add_argument('--duration', type=float, default=10, help='seconds of traffic per case')
+    parser.add_argument('--warmup', type=float, default=2, help='seconds between receiver and sender start')
+    parser.add_argument('--rate-pps', type=float, default=0, help='offered load, 0 = as fast as possible')
+    parser.add_argument('--rx-poll', default='', choices=['', 'busy', 'adaptive', 'interrupt'],
+                        help='receiver --poll mode; by default DPDK busy-polls and sockets use adaptive')
+    parser.add_argument('--out', default='results_matrix.csv', help='CSV file for the results matrix')
+    parser.add_argument('--json-out', default='', help='optional JSON file for the results matrix')
+    parser.add_argument('--log-dir', default='', help='keep the console output of every run here')
+    args = parser.parse_args()
+
+    if os.geteuid() != 0:
+        sys.exit('Root privileges are required for network namespaces and raw sockets')
+
+    engines = parse_list(args.engines)
+    unknown = [e for e in engines if e not in ALL_ENGINES]
+    if unknown:
+        sys.exit('Unknown engines: ' + ','.join(unknown))
+    if args.log_dir:
+        os.makedirs(args.log_dir, exist_ok=True)
+
+    rows = []
+    setup_netns()
+    try:
+        for engine in engines:
+            for size in parse_list(args.sizes, int):
+                for threads in parse_list(args.threads, int):
+                    if engine in XDP_ENGINES and threads > 1:
+                        continue  # одна очередь veth - один AF_XDP сокет
+                    print('Running %s size=%d threads=%d ...' % (engine, size, threads), flush=True)
+                    tx, rx = run_case(args, engine, size, threads)
+                    rows.append(result_row(engine, size, threads, tx, rx))
+    finally:
+        teardown_netns()
+
+    print()
+    print_matrix(rows)
+    with open(args.out, 'w', newline='') as f:
+        writer = csv.DictWriter(f, fieldnames=COLUMNS)
+        writer.writeheader()
+        writer.writerows(rows)
+    if args.json_out:
+        with open(args.json_out, 'w') as f:
+            json.dump(rows, f, indent=2)
+
+    # Ненулевой код возврата, если хотя бы один прогон не дал результатов
+    return 0 if all(r['status'] == 'ok' for r in rows) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
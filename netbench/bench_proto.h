@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
+#include <iomanip>
+#include <ostream>
+#include <net/ethernet.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+
+// Заголовок теста в начале данных UDP
+constexpr uint32_t BENCH_MAGIC = 0x4e424e43;  // "NBNC"
+constexpr size_t BENCH_IP_OFFSET = sizeof(struct ether_header);
+constexpr size_t BENCH_UDP_OFFSET = BENCH_IP_OFFSET + sizeof(struct iphdr);
+constexpr size_t BENCH_HEADER_OFFSET = BENCH_UDP_OFFSET + sizeof(struct udphdr);
+constexpr size_t MAX_STREAMS = 64;
+
+// Ставится на отражённых кадрах
+constexpr uint16_t BENCH_FLAG_REFLECTED = 0x0001;
+
+struct __attribute__((packed)) BenchHeader {
+    uint32_t magic;      // BENCH_MAGIC, big endian
+    uint16_t stream_id;  // поток или очередь отправителя, big endian
+    uint16_t flags;      // BENCH_FLAG_*, big endian
+    uint64_t seq;        // номер кадра в потоке, big endian
+    uint64_t timestamp;  // время отправки по часам отправителя
+};
+
+constexpr size_t BENCH_MIN_FRAME = BENCH_HEADER_OFFSET + sizeof(BenchHeader);
+
+inline void bench_header_write(uint8_t *frame, uint16_t stream_id, uint64_t seq) {
+    BenchHeader hdr;
+    hdr.magic = htobe32(BENCH_MAGIC);
+    hdr.stream_id = htobe16(stream_id);
+    hdr.flags = 0;
+    hdr.seq = htobe64(seq);
+    hdr.timestamp = 0;
+    std::memcpy(frame + BENCH_HEADER_OFFSET, &hdr, sizeof(hdr));
+}
+
+inline void bench_header_set_timestamp(uint8_t *frame, uint64_t timestamp) {
+    std::memcpy(frame + BENCH_HEADER_OFFSET + offsetof(BenchHeader, timestamp), &timestamp, sizeof(timestamp));
+}
+
+inline uint64_t bench_header_timestamp(const uint8_t *frame) {
+    uint64_t timestamp;
+    std::memcpy(&timestamp, frame + BENCH_HEADER_OFFSET + offsetof(BenchHeader, timestamp), sizeof(timestamp));
+    return timestamp;
+}
+
+inline uint16_t bench_header_flags(const uint8_t *frame) {
+    uint16_t flags;
+    std::memcpy(&flags, frame + BENCH_HEADER_OFFSET + offsetof(BenchHeader, flags), sizeof(flags));
+    return be16toh(flags);
+}
+
+// Свёртка 32-битной суммы в контрольную сумму
+inline uint16_t csum_fold(uint64_t sum) {
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+// Обновление контрольной суммы по RFC 1624
+inline uint16_t csum_replace(uint16_t check, uint16_t old_word, uint16_t new_word) {
+    return csum_fold(static_cast<uint16_t>(~check) + static_cast<uint16_t>(~old_word) + new_word);
+}
+
+// Разворот кадра на месте: обмен адресов и портов, флаг отражения
+inline void bench_reflect(uint8_t *frame) {
+    auto swap_bytes = [frame](size_t a, size_t b, size_t len) {
+        uint8_t tmp[ETH_ALEN];
+        std::memcpy(tmp, frame + a, len);
+        std::memcpy(frame + a, frame + b, len);
+        std::memcpy(frame + b, tmp, len);
+    };
+    swap_bytes(offsetof(struct ether_header, ether_dhost), offsetof(struct ether_header, ether_shost), ETH_ALEN);
+    swap_bytes(BENCH_IP_OFFSET + offsetof(struct iphdr, saddr), BENCH_IP_OFFSET + offsetof(struct iphdr, daddr), 4);
+    swap_bytes(BENCH_UDP_OFFSET + offsetof(struct udphdr, source), BENCH_UDP_OFFSET + offsetof(struct udphdr, dest), 2);
+
+    uint16_t old_flags = bench_header_flags(frame);
+    uint16_t flags = htobe16(old_flags | BENCH_FLAG_REFLECTED);
+    std::memcpy(frame + BENCH_HEADER_OFFSET + offsetof(BenchHeader, flags), &flags, sizeof(flags));
+
+    uint16_t check;
+    std::memcpy(&check, frame + BENCH_UDP_OFFSET + offsetof(struct udphdr, check), sizeof(check));
+    if (check != 0) {  // 0 - без контрольной суммы
+        check = csum_replace(be16toh(check), old_flags, old_flags | BENCH_FLAG_REFLECTED);
+        check = htobe16(check == 0 ? 0xffff : check);
+        std::memcpy(frame + BENCH_UDP_OFFSET + offsetof(struct udphdr, check), &check, sizeof(check));
+    }
+}
+
+// Замена только номера кадра
+inline void bench_header_set_seq(uint8_t *frame, uint64_t seq) {
+    uint64_t be_seq = htobe64(seq);
+    std::memcpy(frame + BENCH_HEADER_OFFSET + offsetof(BenchHeader, seq), &be_seq, sizeof(be_seq));
+}
+
+// Длина кадра по длине IPv4, для обрезанных фильтром кадров
+inline size_t bench_frame_len(const uint8_t *frame) {
+    uint16_t tot_len;
+    std::memcpy(&tot_len, frame + BENCH_IP_OFFSET + offsetof(struct iphdr, tot_len), sizeof(tot_len));
+    return BENCH_IP_OFFSET + be16toh(tot_len);
+}
+
+// false для коротких кадров и кадров без BENCH_MAGIC
+inline bool bench_header_parse(const uint8_t *frame, size_t len, uint16_t *stream_id, uint64_t *seq, uint16_t *flags = nullptr) {
+    if (len < BENCH_MIN_FRAME) {
+        return false;
+    }
+    BenchHeader hdr;
+    std::memcpy(&hdr, frame + BENCH_HEADER_OFFSET, sizeof(hdr));
+    if (be32toh(hdr.magic) != BENCH_MAGIC) {
+        return false;
+    }
+    *stream_id = be16toh(hdr.stream_id);
+    *seq = be64toh(hdr.seq);
+    if (flags) {
+        *flags = be16toh(hdr.flags);
+    }
+    return true;
+}
+
+// Счётчик с одним писателем
+inline void counter_add(std::atomic<uint64_t> &counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+// Учёт номеров кадров потока с окном SEQ_WINDOW
+class SeqTracker {
+public:
+    static constexpr uint64_t SEQ_WINDOW = 4096;
+
+    std::atomic<uint64_t> received{0};    // уникальные кадры
+    std::atomic<uint64_t> duplicates{0};
+    std::atomic<uint64_t> reordered{0};   // пришли после большего номера
+    std::atomic<uint64_t> late{0};        // старше окна
+    std::atomic<uint64_t> expected{0};    // наибольший - первый + 1
+    // Для объединения потока нескольких потоков приёма, действительны при expected != 0
+    std::atomic<uint64_t> first_seq{0};
+    std::atomic<uint64_t> highest_seq{0};
+
+    void record(uint64_t seq) {
+        if (!started) {
+            started = true;
+            first = highest = seq;
+            set(seq);
+            counter_add(received, 1);
+            first_seq.store(seq, std::memory_order_relaxed);
+            highest_seq.store(seq, std::memory_order_relaxed);
+            expected.store(1, std::memory_order_release);
+            return;
+        }
+
+        if (seq > highest) {
+            if (seq - highest >= SEQ_WINDOW) {
+                window.fill(0);
+            } else {
+                for (uint64_t s = highest + 1; s < seq; s++) {
+                    clear(s);
+                }
+            }
+            highest = seq;
+            set(seq);
+            counter_add(received, 1);
+            highest_seq.store(highest, std::memory_order_relaxed);
+            expected.store(highest - first + 1, std::memory_order_release);
+        } else if (seq < first || highest - seq >= SEQ_WINDOW) {
+            counter_add(late, 1);
+        } else if (test(seq)) {
+            counter_add(duplicates, 1);
+        } else {
+            set(seq);
+            counter_add(received, 1);
+            counter_add(reordered, 1);
+        }
+    }
+
+private:
+    bool started = false;
+    uint64_t first = 0;
+    uint64_t highest = 0;
+    std::array<uint64_t, SEQ_WINDOW / 64> window{};
+
+    void set(uint64_t seq) { window[(seq / 64) % window.size()] |= 1ULL << (seq % 64); }
+    void clear(uint64_t seq) { window[(seq / 64) % window.size()] &= ~(1ULL << (seq % 64)); }
+    bool test(uint64_t seq) const { return window[(seq / 64) % window.size()] & (1ULL << (seq % 64)); }
+};
+
+// Учёт всех потоков одного потока приёма
+struct StreamTable {
+    std::array<SeqTracker, MAX_STREAMS> streams;
+    std::atomic<uint64_t> foreign_packets{0};  // кадры без заголовка теста
+
+    // true для кадров теста
+    bool record(const uint8_t *frame, size_t len) {
+        uint16_t stream_id;
+        uint64_t seq;
+        uint16_t flags;
+        if (!bench_header_parse(frame, len, &stream_id, &seq, &flags) || stream_id >= MAX_STREAMS ||
+            (flags & BENCH_FLAG_REFLECTED)) {
+            counter_add(foreign_packets, 1);
+            return false;
+        }
+        streams[stream_id].record(seq);
+        return true;
+    }
+};
+
+struct StreamTotals {
+    uint64_t received = 0;
+    uint64_t expected = 0;
+    uint64_t lost = 0;
+    uint64_t duplicates = 0;
+    uint64_t reordered = 0;
+    uint64_t late = 0;
+
+    double loss_rate() const { return expected ? static_cast<double>(lost) / expected : 0.0; }
+};
+
+// Сумма по потоку (или всем) со всех потоков приёма
+inline StreamTotals stream_totals(const StreamTable *tables, size_t nb_tables, size_t stream_id = MAX_STREAMS) {
+    StreamTotals totals;
+    for (size_t s = 0; s < MAX_STREAMS; s++) {
+        if (stream_id != MAX_STREAMS && s != stream_id) {
+            continue;
+        }
+        uint64_t received = 0, lowest = UINT64_MAX, highest = 0;
+        for (size_t t = 0; t < nb_tables; t++) {
+            const SeqTracker &tracker = tables[t].streams[s];
+            if (tracker.expected.load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            received += tracker.received.load(std::memory_order_relaxed);
+            lowest = std::min(lowest, tracker.first_seq.load(std::memory_order_relaxed));
+            highest = std::max(highest, tracker.highest_seq.load(std::memory_order_relaxed));
+            totals.duplicates += tracker.duplicates.load(std::memory_order_relaxed);
+            totals.reordered += tracker.reordered.load(std::memory_order_relaxed);
+            totals.late += tracker.late.load(std::memory_order_relaxed);
+        }
+        if (received == 0) {
+            continue;
+        }
+        uint64_t expected = highest - lowest + 1;
+        totals.received += received;
+        totals.expected += expected;
+        totals.lost += expected > received ? expected - received : 0;
+    }
+    return totals;
+}
+
+inline void print_stream_report(std::ostream &os, const StreamTable *tables, size_t nb_tables) {
+    uint64_t foreign = 0;
+    for (size_t t = 0; t < nb_tables; t++) {
+        foreign += tables[t].foreign_packets.load(std::memory_order_relaxed);
+    }
+    for (size_t s = 0; s < MAX_STREAMS; s++) {
+        StreamTotals st = stream_totals(tables, nb_tables, s);
+        if (st.expected == 0) {
+            continue;
+        }
+        os << "Stream " << s << ": " << st.received << "/" << st.expected << " received, "
+           << st.lost << " lost (" << std::fixed << std::setprecision(4) << st.loss_rate() * 100 << "%), "
+           << st.duplicates << " duplicates, " << st.reordered << " reordered, " << st.late << " late" << std::endl;
+    }
+    os << "Non-benchmark frames: " << foreign << std::endl;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+#include <x86intrin.h>
+
+// Этапы итерации, измеряемые с --profile
+enum BurstPhase { PHASE_ALLOC, PHASE_FRAME, PHASE_BURST, PHASE_FREE };
+constexpr size_t BURST_PHASES = 4;
+inline const char *const BURST_PHASE_NAMES[BURST_PHASES] = {"alloc", "frame", "burst", "free"};
+
+// Наибольший пакет в гистограмме заполнения
+constexpr unsigned PROFILE_MAX_BURST = 64;
+
+// Счётчики одного потока, читаются после остановки
+struct alignas(64) BurstProfileData {
+    uint64_t loop_cycles = 0;
+    uint64_t bursts = 0;
+    uint64_t packets = 0;
+    std::array<uint64_t, BURST_PHASES> cycles{};
+    std::array<uint64_t, PROFILE_MAX_BURST + 1> fill{};  // пакеты по числу кадров
+};
+
+// Замеры TSC в цикле DPDK; без Enabled вызовы ничего не делают
+template <bool Enabled>
+class BurstProfiler {
+public:
+    explicit BurstProfiler(BurstProfileData *data) : data(data) {
+        if constexpr (Enabled) {
+            start = last = __rdtsc();
+        }
+    }
+
+    // Учёт тактов с прошлой отметки в этапе phase
+    void mark(BurstPhase phase) {
+        if constexpr (Enabled) {
+            uint64_t now = __rdtsc();
+            data->cycles[phase] += now - last;
+            last = now;
+        }
+    }
+
+    // Начало этапа без учёта предыдущего времени
+    void skip() {
+        if constexpr (Enabled) {
+            last = __rdtsc();
+        }
+    }
+
+    // Кадры одного вызова rte_eth_*_burst
+    void burst(unsigned nb) {
+        if constexpr (Enabled) {
+            data->bursts++;
+            data->packets += nb;
+            data->fill[nb < PROFILE_MAX_BURST ? nb : PROFILE_MAX_BURST]++;
+        }
+    }
+
+    // Вызывать в конце цикла
+    void finish() {
+        if constexpr (Enabled) {
+            data->loop_cycles += __rdtsc() - start;
+        }
+    }
+
+private:
+    BurstProfileData *data;
+    uint64_t start = 0;
+    uint64_t last = 0;
+};
+
+// Итоги по всем потокам: такты по этапам и заполнение пакетов
+inline void print_burst_profile(std::ostream &os, const char *role, const std::vector<BurstProfileData> &workers,
+                                unsigned burst_size, uint64_t tsc_hz) {
+    BurstProfileData total;
+    for (const BurstProfileData &w : workers) {
+        total.loop_cycles += w.loop_cycles;
+        total.bursts += w.bursts;
+        total.packets += w.packets;
+        for (size_t p = 0; p < BURST_PHASES; p++) {
+            total.cycles[p] += w.cycles[p];
+        }
+        for (size_t n = 0; n <= PROFILE_MAX_BURST; n++) {
+            total.fill[n] += w.fill[n];
+        }
+    }
+    if (total.bursts == 0) {
+        return;
+    }
+
+    uint64_t charged = 0;
+    for (uint64_t c : total.cycles) {
+        charged += c;
+    }
+    double packets = std::max<uint64_t>(total.packets, 1);
+    double bursts = total.bursts;
+    os << std::fixed << std::setprecision(1)
+       << role << " hot path (TSC " << tsc_hz / 1e9 << " GHz): " << total.bursts << " bursts, "
+       << 100.0 * total.fill[0] / bursts << "% empty, fill " << total.packets / bursts << "/" << burst_size
+       << " (" << 100.0 * total.packets / (bursts * burst_size) << "%)" << std::endl;
+
+    os << "  cycles/packet " << charged / packets << " (";
+    bool first = true;
+    for (size_t p = 0; p < BURST_PHASES; p++) {
+        if (total.cycles[p] == 0) {
+            continue;  // например, alloc на приёме нет
+        }
+        os << (first ? "" : ", ") << BURST_PHASE_NAMES[p] << " " << total.cycles[p] / packets;
+        first = false;
+    }
+    uint64_t rest = total.loop_cycles > charged ? total.loop_cycles - charged : 0;
+    os << "), cycles/burst " << charged / bursts << ", rest of the loop "
+       << 100.0 * rest / std::max<uint64_t>(total.loop_cycles, 1) << "%" << std::endl;
+
+    // 0, затем восьмые доли burst_size
+    os << "  burst fill: 0: " << 100.0 * total.fill[0] / bursts << "%";
+    unsigned lo = 1;
+    for (unsigned eighth = 1; eighth <= 8 && lo < burst_size; eighth++) {
+        unsigned hi = std::max(lo, burst_size * eighth / 8);
+        if (hi >= burst_size) {
+            hi = burst_size - 1;
+        }
+        uint64_t count = 0;
+        for (unsigned n = lo; n <= hi && n < PROFILE_MAX_BURST; n++) {
+            count += total.fill[n];
+        }
+        os << "  " << lo << "-" << hi << ": " << 100.0 * count / bursts << "%";
+        lo = hi + 1;
+    }
+    os << "  " << burst_size << ": " << 100.0 * total.fill[std::min(burst_size, PROFILE_MAX_BURST)] / bursts << "%" << std::endl;
+}
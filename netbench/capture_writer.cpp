@@ -0,0 +1,315 @@
+#include "capture_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+
+#include "token_bucket.h"
+#include "uring.h"
+
+constexpr uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;
+constexpr uint32_t LINKTYPE_ETHERNET = 1;
+constexpr uint32_t PCAP_MAX_SNAPLEN = 262144;
+constexpr size_t DIRECT_ALIGN = 4096;       // кратно любому размеру блока
+constexpr unsigned WRITES_IN_FLIGHT = 8;
+
+static uint64_t realtime_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t monotonic_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CaptureWriter::~CaptureWriter() {
+    if (writer.joinable()) {
+        closing.store(true, std::memory_order_release);
+        writer.join();
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool CaptureWriter::open(const std::string &file, uint32_t snap, size_t buffer_size, bool uring) {
+    path = file;
+    snaplen = snap ? snap : PCAP_MAX_SNAPLEN;
+    use_uring = uring;
+    nb_chunks = std::max<size_t>(4, buffer_size / CAPTURE_CHUNK_SIZE);
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    direct = fd >= 0;
+    if (fd < 0 && errno == EINVAL) {
+        // tmpfs и некоторые другие ФС
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        std::cerr << path << ": no O_DIRECT on this filesystem, writing through the page cache" << std::endl;
+    }
+    if (fd < 0) {
+        perror(("cannot create " + path).c_str());
+        return false;
+    }
+
+    // Калибровка заранее, а не на первом кадре
+    ns_per_cycle = 1e9 / tsc_hz();
+    return true;
+}
+
+bool CaptureWriter::start() {
+    buffers = std::make_unique<FrameBuffer>(nb_chunks * CAPTURE_CHUNK_SIZE);
+    if (buffers->data() == nullptr) {
+        return false;
+    }
+    full_chunks = std::make_unique<SpscRing<uint32_t>>(nb_chunks);
+    free_chunks = std::make_unique<SpscRing<uint32_t>>(nb_chunks);
+    chunk_len.assign(nb_chunks, 0);
+    chunk_safe.assign(nb_chunks, 0);
+    for (uint32_t c = 1; c < nb_chunks; c++) {
+        free_chunks->push(c);
+    }
+    cur = 0;
+
+    uint32_t header[6] = {PCAP_MAGIC_NS, 2 | (4 << 16), 0, 0, snaplen, LINKTYPE_ETHERNET};
+    append(reinterpret_cast<const uint8_t *>(header), sizeof(header));
+
+    base_tsc = __rdtsc();
+    base_ns = realtime_ns();
+    start_ns = monotonic_ns();
+    writer = std::thread([this] {
+        pin_helper();
+        if (use_uring) {
+            write_loop_uring();
+        } else {
+            write_loop();
+        }
+    });
+    return true;
+}
+
+void CaptureWriter::finish() {
+    if (!writer.joinable()) {
+        return;
+    }
+    end_ns = monotonic_ns();
+    if (fill > 0) {
+        // O_DIRECT пишет целыми блоками, хвост обрезается ниже
+        size_t len = (fill + DIRECT_ALIGN - 1) & ~(DIRECT_ALIGN - 1);
+        memset(chunk(cur) + fill, 0, len - fill);
+        chunk_len[cur] = len;
+        full_chunks->push(cur);
+        cur = NO_CHUNK;
+        fill = 0;
+    }
+    closing.store(true, std::memory_order_release);
+    writer.join();
+    // После ошибки файл обрезается до последней целой записи перед неудачным буфером
+    if (ftruncate(fd, failed ? std::min(failed_size, file_size) : file_size) < 0) {
+        perror("ftruncate capture failed");
+    }
+    close(fd);
+    fd = -1;
+}
+
+// Запись через pwrite() по одному буферу
+void CaptureWriter::write_loop() {
+    uint64_t offset = 0;
+    while (true) {
+        uint32_t c;
+        size_t queued = full_chunks->size();
+        if (!full_chunks->pop(&c)) {
+            if (closing.load(std::memory_order_acquire) && full_chunks->size() == 0) {
+                break;
+            }
+            usleep(100);
+            continue;
+        }
+        peak_queued = std::max(peak_queued, queued);
+        if (failed) {
+            continue;  // буферы не возвращаются, кадры считаются отброшенными
+        }
+
+        uint64_t t0 = monotonic_ns();
+        size_t done = 0;
+        while (done < chunk_len[c]) {
+            ssize_t n = pwrite(fd, chunk(c) + done, chunk_len[c] - done, offset + done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                perror(("capture write to " + path + " failed").c_str());
+                failed = true;
+                failed_size = chunk_safe[c];
+                break;
+            }
+            done += n;
+        }
+        busy_ns += monotonic_ns() - t0;
+        offset += done;
+        written += done;
+        if (!failed) {
+            free_chunks->push(c);
+        }
+    }
+}
+
+// Запись через io_uring, до WRITES_IN_FLIGHT буферов одновременно
+void CaptureWriter::write_loop_uring() {
+    unsigned depth = std::min<size_t>(WRITES_IN_FLIGHT, nb_chunks);
+    Uring ring;
+    if (!uring_init(&ring, depth, false) || !uring_register(&ring, fd, buffers->data(), buffers->size())) {
+        uring_close(&ring);
+        std::cerr << path << ": io_uring unavailable, writing with pwrite()" << std::endl;
+        write_loop();
+        return;
+    }
+
+    uint64_t offset = 0;
+    unsigned inflight = 0;
+    uint64_t busy_since = 0;
+    while (true) {
+        uint32_t c;
+        unsigned submitted = 0;
+        while (inflight + submitted < depth && !failed) {
+            size_t queued = full_chunks->size();
+            if (!full_chunks->pop(&c)) {
+                break;
+            }
+            peak_queued = std::max(peak_queued, queued);
+            struct io_uring_sqe *sqe = ring.get_sqe();
+            uring_prep_fixed(sqe, IORING_OP_WRITE_FIXED, chunk(c), chunk_len[c], c);
+            sqe->off = offset;
+            offset += chunk_len[c];
+            submitted++;
+        }
+        if (submitted > 0) {
+            if (inflight == 0) {
+                busy_since = monotonic_ns();
+            }
+            inflight += submitted;
+            ring.submit(false);
+        }
+
+        unsigned reaped = ring.for_each_cqe([&](const struct io_uring_cqe &cqe) {
+            inflight--;
+            uint32_t done = cqe.user_data;
+            // Неполная запись означает ошибку (диск заполнен)
+            if (cqe.res != static_cast<int>(chunk_len[done])) {
+                if (!failed) {
+                    std::cerr << "capture write to " << path << " failed: "
+                              << (cqe.res < 0 ? strerror(-cqe.res) : "short write") << std::endl;
+                }
+                failed = true;
+                failed_size = std::min(failed_size, chunk_safe[done]);
+                return;
+            }
+            written += cqe.res;
+            if (!failed) {
+                free_chunks->push(done);
+            }
+        });
+        if (reaped > 0 && inflight == 0) {
+            busy_ns += monotonic_ns() - busy_since;
+        }
+
+        if (failed) {
+            // Дальше ничего не пишется, очередь сбрасывается
+            while (full_chunks->pop(&c)) {
+            }
+        }
+        if (inflight == 0 && closing.load(std::memory_order_acquire) && full_chunks->size() == 0) {
+            break;
+        }
+        if (submitted == 0 && reaped == 0) {
+            if (inflight > 0) {
+                ring.wait_cqe(10);
+            } else {
+                usleep(100);
+            }
+        }
+    }
+    uring_close(&ring);
+}
+
+void CaptureWriter::report(std::ostream &os) const {
+    uint64_t attempts = captured() + dropped();
+    double seconds = end_ns > start_ns ? (end_ns - start_ns) / 1e9 : 0;
+    os << std::fixed << std::setprecision(2) << "Capture " << path << ": " << captured() << " frames, "
+       << captured_bytes() << " bytes, " << dropped() << " dropped by backpressure";
+    if (attempts > 0) {
+        os << " (" << 100.0 * dropped() / attempts << "%)";
+    }
+    os << std::endl;
+    if (seconds > 0) {
+        os << "  captured " << captured() / seconds / 1e6 << " Mpps, " << captured_bytes() * 8 / seconds / 1e9
+           << " Gbit/s; written " << written / seconds / 1e6 << " MB/s";
+        if (busy_ns > 0) {
+            os << " (" << written / (busy_ns / 1e9) / 1e6 << " MB/s while writing)";
+        }
+        os << ", writer busy " << 100.0 * busy_ns / (end_ns - start_ns) << "%, peak " << peak_queued << "/"
+           << nb_chunks << " buffers queued, " << (direct ? "O_DIRECT" : "page cache") << ", "
+           << (use_uring ? "io_uring" : "pwrite") << std::endl;
+    }
+    if (failed) {
+        os << "  writing failed, the capture is cut after the last frame written" << std::endl;
+    }
+}
+
+// cap.pcap -> cap.2.pcap, cap -> cap.2
+static std::string worker_path(const std::string &path, unsigned worker_id) {
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + "." + std::to_string(worker_id);
+    }
+    return path.substr(0, dot) + "." + std::to_string(worker_id) + path.substr(dot);
+}
+
+bool CaptureSet::open(const Options &opts, unsigned nb_workers) {
+    if (opts.record.empty()) {
+        return true;
+    }
+    if (opts.record_io != "uring" && opts.record_io != "pwrite") {
+        std::cerr << "Unknown record I/O: " << opts.record_io << " (expected uring or pwrite)" << std::endl;
+        return false;
+    }
+    for (unsigned i = 0; i < nb_workers; i++) {
+        writers.push_back(std::make_unique<CaptureWriter>());
+        std::string path = nb_workers == 1 ? opts.record : worker_path(opts.record, i);
+        if (!writers.back()->open(path, opts.record_snaplen, static_cast<size_t>(opts.record_buffer_mb) << 20,
+                                  opts.record_io == "uring")) {
+            return false;
+        }
+    }
+    std::cout << "Recording to " << opts.record << (nb_workers > 1 ? " (one file per worker)" : "");
+    if (opts.record_snaplen) {
+        std::cout << ", " << opts.record_snaplen << " bytes per frame";
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+void CaptureSet::counters(DeviceCounters *counters) const {
+    if (writers.empty()) {
+        return;
+    }
+    uint64_t packets = 0, drops = 0;
+    for (const auto &w : writers) {
+        packets += w->captured();
+        drops += w->dropped();
+    }
+    counters->push_back(DeviceCounter{"capture_packets", packets, CounterKind::Info});
+    counters->push_back(DeviceCounter{"capture_drops", drops, CounterKind::Info});
+}
+
+void CaptureSet::report(std::ostream &os) const {
+    for (const auto &w : writers) {
+        w->report(os);
+    }
+}
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <x86intrin.h>
+
+#include "device_counters.h"
+#include "options.h"
+#include "placement.h"
+
+// Кольцо без блокировок: один производитель, один потребитель
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) {
+            cap <<= 1;
+        }
+        slots.resize(cap);
+        mask = cap - 1;
+    }
+
+    bool push(const T &value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache > mask) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache > mask) {
+                return false;
+            }
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T *value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) {
+                return false;
+            }
+        }
+        *value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Число элементов; точно только у потребителя
+    size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> tail{0};  // сторона производителя
+    size_t head_cache = 0;
+    alignas(64) std::atomic<size_t> head{0};  // сторона потребителя
+    size_t tail_cache = 0;
+};
+
+// Размер одного буфера записи
+constexpr size_t CAPTURE_CHUNK_SIZE = 4 << 20;
+
+// Запись pcap для одного потока приёма (--record), кадры без свободного буфера отбрасываются
+class CaptureWriter {
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    // Создание файла, по возможности с O_DIRECT
+    bool open(const std::string &path, uint32_t snaplen, size_t buffer_size, bool use_uring);
+
+    // Выделение буферов и запуск потока записи
+    bool start();
+
+    // Время в наносекундах по TSC
+    uint64_t now_ns() const { return base_ns + static_cast<uint64_t>((__rdtsc() - base_tsc) * ns_per_cycle); }
+
+    // Добавление кадра: caplen байт сохраняется, len - длина в сети
+    void add(const uint8_t *frame, uint32_t caplen, uint32_t len, uint64_t ts_ns) {
+        if (caplen > snaplen) {
+            caplen = snaplen;
+        }
+        if (!reserve(16 + caplen)) {
+            drops.store(drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        record_begin = file_size;
+        record_end = file_size + 16 + caplen;
+        uint32_t hdr[4] = {static_cast<uint32_t>(ts_ns / 1000000000), static_cast<uint32_t>(ts_ns % 1000000000), caplen, len};
+        append(reinterpret_cast<const uint8_t *>(hdr), sizeof(hdr));
+        append(frame, caplen);
+        packets.store(packets.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        bytes.store(bytes.load(std::memory_order_relaxed) + caplen, std::memory_order_relaxed);
+    }
+
+    // Запись остатка и закрытие файла
+    void finish();
+
+    uint64_t captured() const { return packets.load(std::memory_order_relaxed); }
+    uint64_t captured_bytes() const { return bytes.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return drops.load(std::memory_order_relaxed); }
+
+    void report(std::ostream &os) const;
+
+private:
+    static constexpr uint32_t NO_CHUNK = UINT32_MAX;
+
+    std::string path;
+    int fd = -1;
+    bool direct = false;
+    bool use_uring = false;
+    uint32_t snaplen = 0;
+    size_t nb_chunks = 0;
+    std::unique_ptr<FrameBuffer> buffers;
+    std::unique_ptr<SpscRing<uint32_t>> full_chunks;  // поток приёма -> запись
+    std::unique_ptr<SpscRing<uint32_t>> free_chunks;  // запись -> поток приёма
+    std::vector<uint32_t> chunk_len;                  // байт к записи в каждом буфере
+    std::vector<uint64_t> chunk_safe;                 // последняя граница записи pcap до начала буфера
+    std::thread writer;
+    std::atomic<bool> closing{false};
+
+    // Сторона потока приёма
+    uint32_t cur = NO_CHUNK;
+    uint32_t spare = NO_CHUNK;  // для записи, не влезающей в cur
+    size_t fill = 0;
+    uint64_t file_size = 0;     // итоговый размер файла
+    uint64_t record_begin = 0;
+    uint64_t record_end = 0;
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> drops{0};
+
+    // Сторона записи, читается после finish()
+    uint64_t written = 0;
+    uint64_t busy_ns = 0;       // время с незавершённой записью
+    size_t peak_queued = 0;
+    bool failed = false;
+    uint64_t failed_size = UINT64_MAX;  // размер файла после ошибки записи
+
+    uint64_t base_ns = 0;
+    uint64_t base_tsc = 0;
+    double ns_per_cycle = 0;
+    uint64_t start_ns = 0;
+    uint64_t end_ns = 0;
+
+    uint8_t *chunk(uint32_t c) const { return buffers->data() + static_cast<size_t>(c) * CAPTURE_CHUNK_SIZE; }
+
+    bool reserve(size_t need) {
+        if (cur == NO_CHUNK) {
+            if (!free_chunks->pop(&cur)) {
+                return false;
+            }
+            chunk_safe[cur] = file_size;
+        }
+        if (fill + need <= CAPTURE_CHUNK_SIZE) {
+            return true;
+        }
+        return spare != NO_CHUNK || free_chunks->pop(&spare);
+    }
+
+    void append(const uint8_t *data, size_t len) {
+        while (len > 0) {
+            size_t n = len < CAPTURE_CHUNK_SIZE - fill ? len : CAPTURE_CHUNK_SIZE - fill;
+            memcpy(chunk(cur) + fill, data, n);
+            fill += n;
+            data += n;
+            len -= n;
+            file_size += n;
+            if (fill == CAPTURE_CHUNK_SIZE) {
+                chunk_len[cur] = CAPTURE_CHUNK_SIZE;
+                full_chunks->push(cur);  // вмещает все буферы
+                cur = spare;
+                spare = NO_CHUNK;
+                fill = 0;
+                if (cur != NO_CHUNK) {
+                    chunk_safe[cur] = file_size == record_end ? file_size : record_begin;
+                }
+            }
+        }
+    }
+
+    void write_loop();
+    void write_loop_uring();
+};
+
+// Запись для всех потоков приёма; пусто без --record
+class CaptureSet {
+public:
+    // Файл на каждый поток: FILE или FILE с .N перед расширением
+    bool open(const Options &opts, unsigned nb_workers);
+
+    // nullptr без записи
+    CaptureWriter *worker(unsigned worker_id) { return writers.empty() ? nullptr : writers[worker_id].get(); }
+
+    // Итоги для отчёта
+    void counters(DeviceCounters *counters) const;
+
+    void report(std::ostream &os) const;
+
+private:
+    std::vector<std::unique_ptr<CaptureWriter>> writers;
+};
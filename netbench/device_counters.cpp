@@ -0,0 +1,70 @@
+#include "device_counters.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <linux/if_packet.h>
+#include <sys/socket.h>
+
+const char *const LOSS_KIND_NAMES[LOSS_KINDS] = {"queue full", "no buffers", "errors"};
+
+void read_iface_counters(const std::string &ifname, DeviceCounters *counters, bool losses) {
+    // rx_errors пересекается с подробными счётчиками, читаются только они
+    static const std::pair<const char *, CounterKind> files[] = {
+        {"rx_packets", CounterKind::Info},
+        {"tx_packets", CounterKind::Info},
+        {"rx_dropped", CounterKind::QueueFull},        // очередь полна или нет обработчика
+        {"rx_missed_errors", CounterKind::QueueFull},  // кольцо NIC заполнено
+        {"rx_fifo_errors", CounterKind::QueueFull},
+        {"rx_over_errors", CounterKind::QueueFull},
+        {"tx_dropped", CounterKind::QueueFull},
+        {"rx_crc_errors", CounterKind::Error},
+        {"rx_length_errors", CounterKind::Error},
+        {"rx_frame_errors", CounterKind::Error},
+        {"tx_errors", CounterKind::Error},
+    };
+    const std::string dir = "/sys/class/net/" + ifname + "/statistics/";
+    for (const auto &[file, kind] : files) {
+        std::ifstream in(dir + file);
+        uint64_t value;
+        if (in >> value) {
+            counters->push_back(DeviceCounter{std::string("if_") + file, value, losses ? kind : CounterKind::Info});
+        }
+    }
+}
+
+void PacketSocketCounters::add(int sockfd) {
+    std::lock_guard<std::mutex> guard(lock);
+    fds.push_back(sockfd);
+}
+
+void PacketSocketCounters::remove(int sockfd) {
+    std::lock_guard<std::mutex> guard(lock);
+    collect(sockfd);
+    fds.erase(std::remove(fds.begin(), fds.end(), sockfd), fds.end());
+}
+
+void PacketSocketCounters::read(DeviceCounters *counters) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (int fd : fds) {
+        collect(fd);
+    }
+    counters->push_back(DeviceCounter{"sock_packets", packets, CounterKind::Info});
+    counters->push_back(DeviceCounter{"sock_drops", drops, CounterKind::QueueFull});
+    counters->push_back(DeviceCounter{"sock_freezes", freezes, CounterKind::Info});
+}
+
+// tp_packets включает отброшенные кадры
+void PacketSocketCounters::collect(int sockfd) {
+    struct tpacket_stats_v3 st = {};
+    socklen_t len = sizeof(st);
+    if (getsockopt(sockfd, SOL_PACKET, PACKET_STATISTICS, &st, &len) < 0) {
+        perror("getsockopt PACKET_STATISTICS failed");
+        return;
+    }
+    packets += st.tp_packets;
+    drops += st.tp_drops;
+    if (len >= sizeof(st)) {
+        freezes += st.tp_freeze_q_cnt;
+    }
+}
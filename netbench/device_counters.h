@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Вид счётчика: Info - трафик и события, остальные - потерянные кадры
+enum class CounterKind { Info, QueueFull, NoBuffers, Error };
+constexpr size_t LOSS_KINDS = 3;
+extern const char *const LOSS_KIND_NAMES[LOSS_KINDS];  // QueueFull, NoBuffers, Error
+
+inline size_t loss_index(CounterKind kind) {
+    return static_cast<size_t>(kind) - 1;
+}
+
+// Накопительный счётчик NIC, драйвера, интерфейса или сокета
+struct DeviceCounter {
+    std::string name;
+    uint64_t value = 0;
+    CounterKind kind = CounterKind::Info;
+};
+using DeviceCounters = std::vector<DeviceCounter>;
+
+// Заполнение списка счётчиков, вызывается каждый интервал
+using DeviceCounterSource = std::function<void(DeviceCounters *)>;
+
+// Счётчики интерфейса из /sys/class/net/<ifname>/statistics
+void read_iface_counters(const std::string &ifname, DeviceCounters *counters, bool losses = true);
+
+// Сумма PACKET_STATISTICS сокетов AF_PACKET (ядро сбрасывает их при чтении)
+class PacketSocketCounters {
+public:
+    void add(int sockfd);
+    // Учёт последних значений перед закрытием сокета
+    void remove(int sockfd);
+    void read(DeviceCounters *counters);
+
+private:
+    std::vector<int> fds;
+    uint64_t packets = 0;
+    uint64_t drops = 0;
+    uint64_t freezes = 0;  // кольцо TPACKET_V3 заполнено
+    std::mutex lock;
+
+    void collect(int sockfd);
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+// Только для DPDK-программ, библиотека от DPDK не зависит
+
+#include <string>
+#include <vector>
+
+#include <rte_ethdev.h>
+
+#include "device_counters.h"
+
+// xstats драйвера о потерях, кроме повторяющих rte_eth_stats
+inline bool dpdk_xstat_wanted(const std::string &name) {
+    static const char *const generic[] = {"rx_good_packets", "tx_good_packets", "rx_good_bytes", "tx_good_bytes",
+                                          "rx_missed_errors", "rx_errors", "tx_errors", "rx_mbuf_allocation_errors"};
+    for (const char *g : generic) {
+        if (name == g) {
+            return false;
+        }
+    }
+    if (name.size() > 4 && (name.compare(0, 4, "rx_q") == 0 || name.compare(0, 4, "tx_q") == 0) &&
+        name[4] >= '0' && name[4] <= '9') {
+        return false;
+    }
+    for (const char *part : {"drop", "discard", "miss", "full", "overflow", "fifo", "nombuf", "buffer", "alloc", "err", "crc", "invalid"}) {
+        if (name.find(part) != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Счётчики порта: rte_eth_stats и xstats драйвера о потерях
+class DpdkPortCounters {
+public:
+    // Вызывать после запуска порта
+    void init(uint16_t port_id) {
+        port = port_id;
+        int nb = rte_eth_xstats_get_names(port, nullptr, 0);
+        if (nb <= 0) {
+            return;
+        }
+        std::vector<rte_eth_xstat_name> xstat_names(nb);
+        if (rte_eth_xstats_get_names(port, xstat_names.data(), nb) != nb) {
+            return;
+        }
+        xstats.resize(nb);
+        for (int i = 0; i < nb; i++) {
+            if (dpdk_xstat_wanted(xstat_names[i].name)) {
+                picked.push_back(PickedXstat{static_cast<size_t>(i), xstat_names[i].name});
+            }
+        }
+    }
+
+    void read(DeviceCounters *counters) {
+        struct rte_eth_stats st;
+        if (rte_eth_stats_get(port, &st) == 0) {
+            counters->push_back(DeviceCounter{"ipackets", st.ipackets, CounterKind::Info});
+            counters->push_back(DeviceCounter{"opackets", st.opackets, CounterKind::Info});
+            counters->push_back(DeviceCounter{"imissed", st.imissed, CounterKind::QueueFull});  // кольцо RX заполнено
+            counters->push_back(DeviceCounter{"rx_nombuf", st.rx_nombuf, CounterKind::NoBuffers});
+            counters->push_back(DeviceCounter{"ierrors", st.ierrors, CounterKind::Error});
+            counters->push_back(DeviceCounter{"oerrors", st.oerrors, CounterKind::Error});
+        }
+        if (picked.empty() || rte_eth_xstats_get(port, xstats.data(), xstats.size()) != static_cast<int>(xstats.size())) {
+            return;
+        }
+        for (const PickedXstat &x : picked) {
+            counters->push_back(DeviceCounter{x.name, xstats[x.index].value, CounterKind::Info});
+        }
+    }
+
+private:
+    struct PickedXstat {
+        size_t index;  // индекс в массиве rte_eth_xstats_get
+        std::string name;
+    };
+
+    uint16_t port = 0;
+    std::vector<PickedXstat> picked;
+    std::vector<rte_eth_xstat> xstats;
+};
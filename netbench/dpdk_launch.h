@@ -0,0 +1,37 @@
+#pragma once
+
+// Только для DPDK-программ, библиотека от DPDK не зависит
+
+#include <vector>
+
+#include <rte_launch.h>
+#include <rte_lcore.h>
+
+#include "engine.h"
+
+struct LcoreTask {
+    const WorkerBody *body;
+    unsigned worker_id;
+};
+
+inline int run_lcore_task(void *arg) {
+    auto *task = static_cast<LcoreTask *>(arg);
+    (*task->body)(task->worker_id);
+    return 0;
+}
+
+// Запуск потока i на i-м рабочем lcore и ожидание всех
+inline void launch_on_worker_lcores(unsigned nb_workers, const WorkerBody &body) {
+    std::vector<LcoreTask> tasks(nb_workers);
+    unsigned lcore_id;
+    unsigned worker_id = 0;
+    RTE_LCORE_FOREACH_WORKER(lcore_id) {
+        if (worker_id == nb_workers) {
+            break;
+        }
+        tasks[worker_id] = LcoreTask{&body, worker_id};
+        rte_eal_remote_launch(run_lcore_task, &tasks[worker_id], lcore_id);
+        worker_id++;
+    }
+    rte_eal_mp_wait_lcore();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+
+#include "bench_proto.h"
+#include "device_counters.h"
+#include "stats.h"
+
+// Тело рабочего потока, аргумент - номер потока
+using WorkerBody = std::function<void(unsigned)>;
+
+// Запуск каждого потока в std::thread и ожидание завершения
+void launch_threads(unsigned nb_workers, const WorkerBody &body);
+
+// Движок отправки; счётчики и отчёты ведёт run_engine()
+class TxEngine {
+public:
+    virtual ~TxEngine() = default;
+
+    // Открытие сокетов и портов; false завершает запуск
+    virtual bool setup() { return true; }
+
+    virtual unsigned nb_workers() const { return 1; }
+
+    // Отправка до stop_requested(), один вызов на поток
+    virtual void transmit(unsigned worker_id, WorkerStats &stats) = 0;
+
+    // Запуск всех потоков и ожидание; DPDK запускает их на lcore
+    virtual void launch(const WorkerBody &body) { launch_threads(nb_workers(), body); }
+
+    // Дополнительные строки итогов
+    virtual void report(std::ostream & /*os*/) const {}
+
+    // Счётчики NIC, драйвера, интерфейса и сокетов
+    virtual void device_counters(DeviceCounters * /*counters*/) {}
+};
+
+// Движок приёма; каждый поток ведёт свою таблицу потоков
+class RxEngine {
+public:
+    virtual ~RxEngine() = default;
+
+    virtual bool setup() { return true; }
+
+    virtual unsigned nb_workers() const { return 1; }
+
+    // Приём до stop_requested(), один вызов на поток
+    virtual void receive(unsigned worker_id, WorkerStats &stats, StreamTable &streams) = 0;
+
+    virtual void launch(const WorkerBody &body) { launch_threads(nb_workers(), body); }
+
+    virtual void report(std::ostream & /*os*/) const {}
+
+    virtual void device_counters(DeviceCounters * /*counters*/) {}
+};
@@ -0,0 +1,119 @@
+#include "frame.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+void get_mac_address(const char *ifname, uint8_t *mac) {
+    struct ifaddrs *ifap, *ifa;
+    getifaddrs(&ifap);
+    for (ifa = ifap; ifa; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr && ifa->ifa_addr->sa_family == AF_PACKET && strcmp(ifa->ifa_name, ifname) == 0) {
+            struct sockaddr_ll *s = (struct sockaddr_ll*)ifa->ifa_addr;
+            memcpy(mac, s->sll_addr, 6);
+            break;
+        }
+    }
+    freeifaddrs(ifap);
+}
+
+unsigned get_mtu(const char *ifname) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    int ret = ioctl(fd, SIOCGIFMTU, &ifr);
+    close(fd);
+    return ret < 0 ? 0 : ifr.ifr_mtu;
+}
+
+// Сумма 16-битных слов буфера чётной длины
+static uint32_t sum_words(const uint8_t *data, size_t len) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+        sum += (data[i] << 8) | data[i + 1];
+    }
+    return sum;
+}
+
+FlowTable::FlowTable(const uint8_t *src_mac, const uint8_t *dst_mac, unsigned nb_flows) {
+    flows.resize(std::clamp(nb_flows, 1u, MAX_FLOWS));
+    for (unsigned i = 0; i < flows.size(); i++) {
+        Flow &flow = flows[i];
+        std::memset(flow.headers, 0, sizeof(flow.headers));
+
+        // Создание Ethernet кадра
+        struct ether_header eh;
+        memcpy(eh.ether_shost, src_mac, 6);
+        memcpy(eh.ether_dhost, dst_mac, 6);
+        eh.ether_type = htons(ETH_P_IP);
+        memcpy(flow.headers, &eh, sizeof(eh));
+
+        // Длины и контрольные суммы заполняются для каждого кадра
+        struct iphdr ip = {};
+        ip.version = 4;
+        ip.ihl = sizeof(ip) / 4;
+        ip.frag_off = htons(IP_DF);
+        ip.ttl = 64;
+        ip.protocol = IPPROTO_UDP;
+        ip.saddr = htonl(BENCH_SRC_IP + i);
+        ip.daddr = htonl(BENCH_DST_IP);
+        memcpy(flow.headers + BENCH_IP_OFFSET, &ip, sizeof(ip));
+
+        struct udphdr udp = {};
+        udp.source = htons(BENCH_SRC_PORT + i);
+        udp.dest = htons(BENCH_DST_PORT);
+        memcpy(flow.headers + BENCH_UDP_OFFSET, &udp, sizeof(udp));
+
+        flow.ip_sum = sum_words(flow.headers + BENCH_IP_OFFSET, sizeof(ip));
+        // Псевдозаголовок: адреса и протокол, длина UDP добавляется позже
+        flow.udp_sum = sum_words(reinterpret_cast<const uint8_t *>(&ip.saddr), 8) + IPPROTO_UDP +
+                       sum_words(flow.headers + BENCH_UDP_OFFSET, sizeof(udp));
+    }
+}
+
+void FlowTable::write_headers(uint8_t *frame, unsigned flow_id, uint16_t frame_len) const {
+    const Flow &flow = flows[flow_id];
+    memcpy(frame, flow.headers, BENCH_HEADER_OFFSET);
+
+    uint16_t ip_len = frame_len - BENCH_IP_OFFSET;
+    uint16_t udp_len = frame_len - BENCH_UDP_OFFSET;
+    uint16_t ip_check = csum_fold(flow.ip_sum + ip_len);
+
+    // Полезная нагрузка: заголовок теста, затем n байт 'A'
+    size_t n = frame_len - BENCH_MIN_FRAME;
+    uint32_t payload_sum = sum_words(frame + BENCH_HEADER_OFFSET, sizeof(BenchHeader)) +
+                           (n / 2) * 0x4141 + (n % 2 ? 0x4100 : 0);
+    uint16_t udp_check = csum_fold(static_cast<uint64_t>(flow.udp_sum) + 2 * udp_len + payload_sum);
+
+    uint8_t *ip = frame + BENCH_IP_OFFSET;
+    uint8_t *udp = frame + BENCH_UDP_OFFSET;
+    ip_len = htons(ip_len);
+    ip_check = htons(ip_check);
+    udp_len = htons(udp_len);
+    // 0 означает "нет контрольной суммы", поэтому отправляется 0xffff
+    udp_check = htons(udp_check == 0 ? 0xffff : udp_check);
+    memcpy(ip + offsetof(struct iphdr, tot_len), &ip_len, 2);
+    memcpy(ip + offsetof(struct iphdr, check), &ip_check, 2);
+    memcpy(udp + offsetof(struct udphdr, len), &udp_len, 2);
+    memcpy(udp + offsetof(struct udphdr, check), &udp_check, 2);
+}
+
+std::vector<uint8_t> build_bench_frame(const FlowTable &flows, size_t frame_len, uint16_t stream_id) {
+    std::vector<uint8_t> frame(std::max(frame_len, BENCH_MIN_FRAME), 'A');
+    bench_header_write(frame.data(), stream_id, 0);
+    flows.write_headers(frame.data(), 0, frame.size());
+    return frame;
+}
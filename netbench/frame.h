@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "bench_proto.h"
+
+// MAC-адрес интерфейса
+void get_mac_address(const char *ifname, uint8_t *mac);
+
+// MTU интерфейса, 0 если неизвестен
+unsigned get_mtu(const char *ifname);
+
+// Адреса трафика IPv4/UDP (диапазон RFC 2544), поток i: BENCH_SRC_IP + i, BENCH_SRC_PORT + i
+constexpr uint32_t BENCH_SRC_IP = 0xc6120001;  // 198.18.0.1
+constexpr uint32_t BENCH_DST_IP = 0xc6130001;  // 198.19.0.1
+constexpr uint16_t BENCH_SRC_PORT = 10000;
+constexpr uint16_t BENCH_DST_PORT = 9;         // discard
+constexpr unsigned MAX_FLOWS = 50000;
+
+// Заголовки Ethernet/IPv4/UDP всех потоков с заранее посчитанными частями контрольных сумм
+class FlowTable {
+public:
+    FlowTable() = default;
+    FlowTable(const uint8_t *src_mac, const uint8_t *dst_mac, unsigned nb_flows);
+
+    unsigned size() const { return flows.size(); }
+    unsigned next(unsigned flow) const { return flow + 1 == flows.size() ? 0 : flow + 1; }
+
+    // Запись заголовков потока flow в кадр длиной frame_len
+    void write_headers(uint8_t *frame, unsigned flow, uint16_t frame_len) const;
+
+private:
+    struct Flow {
+        uint8_t headers[BENCH_HEADER_OFFSET];
+        uint32_t ip_sum;   // заголовок IPv4 без длины
+        uint32_t udp_sum;  // псевдозаголовок и заголовок UDP без длин
+    };
+    std::vector<Flow> flows;
+};
+
+// Кадр длиной frame_len с заголовком теста и заполнением 'A'
+std::vector<uint8_t> build_bench_frame(const FlowTable &flows, size_t frame_len, uint16_t stream_id);
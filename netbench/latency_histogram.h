@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <ostream>
+
+// Лог-линейная гистограмма (как HDR), относительная ошибка меньше 1 / 2^SUB_BUCKET_BITS
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+    static constexpr size_t NB_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        counts[index_of(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        uint64_t prev = max_value.load(std::memory_order_relaxed);
+        while (value > prev && !max_value.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_value.load(std::memory_order_relaxed); }
+
+    // Значение, ниже которого лежит доля fraction (0..1) замеров
+    uint64_t percentile(double fraction) const {
+        uint64_t samples = count();
+        if (samples == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(fraction * samples);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < NB_BUCKETS; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen > rank) {
+                uint64_t upper = value_of(i + 1) - 1;
+                return upper < max() ? upper : max();
+            }
+        }
+        return max();
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, NB_BUCKETS> counts{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> max_value{0};
+
+    static size_t index_of(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return value;
+        }
+        unsigned shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return SUB_BUCKETS + shift * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Наименьшее значение корзины
+    static uint64_t value_of(size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        unsigned shift = index / SUB_BUCKETS - 1;
+        if (shift > 63 - SUB_BUCKET_BITS) {
+            return UINT64_MAX;
+        }
+        return (SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    }
+};
+
+inline uint64_t monotonic_raw_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// Запись в наносекундах, вывод в микросекундах
+inline void print_latency_report(std::ostream &os, const LatencyHistogram &hist) {
+    auto us = [](uint64_t ns) { return ns / 1000.0; };
+    os << std::fixed << std::setprecision(2)
+       << "RTT: " << hist.count() << " samples, p50 " << us(hist.percentile(0.5))
+       << " us, p99 " << us(hist.percentile(0.99))
+       << " us, p99.9 " << us(hist.percentile(0.999))
+       << " us, max " << us(hist.max()) << " us" << std::endl;
+}
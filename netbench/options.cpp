@@ -0,0 +1,95 @@
+#include "options.h"
+
+#include <algorithm>
+#include <sstream>
+
+void parse_mac_address(const std::string &mac_str, uint8_t mac[6]) {
+    std::stringstream ss(mac_str);
+    std::string byte_str;
+    int i = 0;
+
+    while (std::getline(ss, byte_str, ':') && i < 6) {
+        mac[i++] = std::stoi(byte_str, nullptr, 16);
+    }
+}
+
+void parse_options(int argc, char *argv[], Options *opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--iface" && has_value) {
+            opts->iface = argv[++i];
+        } else if (arg == "--dst" && has_value) {
+            parse_mac_address(argv[++i], opts->dst_mac.data());
+        } else if (arg == "--size" && has_value) {
+            opts->size = std::stoi(argv[++i]);
+        } else if (arg == "--size-dist" && has_value) {
+            opts->size_dist = argv[++i];
+        } else if (arg == "--flows" && has_value) {
+            opts->flows = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--no-sleep") {
+            opts->use_sleep = false;
+        } else if (arg == "--rate-pps" && has_value) {
+            opts->rate_pps = std::stod(argv[++i]);
+            opts->use_sleep = false;
+        } else if (arg == "--rate-bps" && has_value) {
+            opts->rate_bps = std::stod(argv[++i]);
+            opts->use_sleep = false;
+        } else if (arg == "--latency") {
+            opts->latency = true;
+        } else if (arg == "--reflect") {
+            opts->reflect = true;
+        } else if (arg == "--replay" && has_value) {
+            opts->replay = argv[++i];
+        } else if (arg == "--replay-speed" && has_value) {
+            std::string speed = argv[++i];
+            opts->replay_speed = speed == "max" ? 0 : std::max(0.0, std::stod(speed));
+        } else if (arg == "--replay-loops" && has_value) {
+            opts->replay_loops = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--record" && has_value) {
+            opts->record = argv[++i];
+        } else if (arg == "--snaplen" && has_value) {
+            opts->record_snaplen = std::stoul(argv[++i]);
+        } else if (arg == "--record-buffer-mb" && has_value) {
+            opts->record_buffer_mb = std::stoul(argv[++i]);
+        } else if (arg == "--record-io" && has_value) {
+            opts->record_io = argv[++i];
+        } else if (arg == "--mode" && has_value) {
+            opts->mode = argv[++i];
+        } else if (arg == "--j" && has_value) {
+            opts->threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--batch" && has_value) {
+            opts->batch = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--qd" && has_value) {
+            opts->qd = std::clamp(std::stoi(argv[++i]), 1, 4096);
+        } else if (arg == "--sqpoll") {
+            opts->sqpoll = true;
+        } else if (arg == "--fanout" && has_value) {
+            opts->fanout = argv[++i];
+        } else if (arg == "--no-filter") {
+            opts->filter = false;
+        } else if (arg == "--poll" && has_value) {
+            opts->poll = argv[++i];
+        } else if (arg == "--poll-sleep-us" && has_value) {
+            opts->poll_sleep_us = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--busy-poll-us" && has_value) {
+            opts->busy_poll_us = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--cpus" && has_value) {
+            opts->cpus = argv[++i];
+        } else if (arg == "--numa-node" && has_value) {
+            opts->numa_node = std::stoi(argv[++i]);
+        } else if (arg == "--hugepages") {
+            opts->hugepages = true;
+        } else if (arg == "--output" && has_value) {
+            opts->output = argv[++i];
+        } else if (arg == "--output-file" && has_value) {
+            opts->output_file = argv[++i];
+        } else if (arg == "--queue" && has_value) {
+            opts->queue = std::stoi(argv[++i]);
+        } else if (arg == "--bind" && has_value) {
+            opts->bind = argv[++i];
+        } else if (arg == "--xdp-mode" && has_value) {
+            opts->xdp_mode = argv[++i];
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Общие параметры командной строки всех программ
+struct Options {
+    // Интерфейс и трафик
+    std::string iface = "enp0s9";
+    std::array<uint8_t, 6> dst_mac = {0x08, 0x00, 0x27, 0x60, 0xff, 0x20};
+    int size = 1024;            // --size: данные после заголовка Ethernet (DPDK: весь кадр)
+    std::string size_dist;      // --size-dist imix|uniform:LO-HI|SIZE[:WEIGHT],..., вместо --size
+    unsigned flows = 1;         // --flows: число потоков IPv4/UDP
+    bool use_sleep = true;      // пауза 1 мс (отправка) или адаптивный опрос (приём)
+    double rate_pps = 0;        // нагрузка на весь процесс, 0 - без ограничения
+    double rate_bps = 0;
+    bool latency = false;       // отправка: метки времени и приём отражённых кадров
+    bool reflect = false;       // приём: отправка кадров обратно
+
+    // Воспроизведение записи (отправка)
+    std::string replay;         // --replay FILE: кадры из pcap/pcapng
+    double replay_speed = 1;    // --replay-speed: множитель скорости, 0 (max) - максимум
+    unsigned replay_loops = 1;  // --replay-loops: число проходов, 0 - до остановки
+
+    // Запись на диск (приём)
+    std::string record;             // --record FILE: запись кадров в pcap
+    uint32_t record_snaplen = 0;    // --snaplen: байт от кадра, 0 - весь кадр
+    unsigned record_buffer_mb = 64; // --record-buffer-mb: буферы на поток
+    std::string record_io = "uring";  // --record-io uring|pwrite
+
+    // Выбор и настройка движка
+    std::string mode;           // --mode, зависит от движка
+    unsigned threads = 1;       // --j
+    unsigned batch = 32;        // кадров за один вызов
+    unsigned qd = 256;          // запросов io_uring в работе
+    bool sqpoll = false;
+    std::string fanout = "hash";
+    bool filter = true;         // приём через сокет: BPF-фильтр кадров теста
+    std::string poll;           // приём: --poll busy|adaptive|interrupt, пусто - по --no-sleep
+    unsigned poll_sleep_us = 1000;  // наибольшая пауза при простое
+    unsigned busy_poll_us = 0;  // приём через сокет: SO_BUSY_POLL
+
+    // Размещение
+    std::string cpus;           // --cpus 0-3,8: CPU рабочих, затем вспомогательных потоков
+    int numa_node = -1;         // --numa-node: потоки на CPU этого узла
+    bool hugepages = false;     // буферы кадров в страницах 2 МБ
+
+    // Результаты для скриптов
+    std::string output;         // --output json|csv, пусто - только консоль
+    std::string output_file;    // --output-file, по умолчанию results.json / results.csv
+
+    // AF_XDP
+    unsigned queue = 0;
+    std::string bind = "auto";
+    std::string xdp_mode = "native";
+};
+
+// Разбор общих параметров, остальные пропускаются
+void parse_options(int argc, char *argv[], Options *opts);
+
+void parse_mac_address(const std::string &mac_str, uint8_t mac[6]);
@@ -0,0 +1,308 @@
+#include "pcap_file.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "runner.h"
+
+constexpr uint32_t PCAP_MAGIC_US = 0xa1b2c3d4;
+constexpr uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;
+constexpr uint32_t PCAPNG_SHB = 0x0a0d0d0a;
+constexpr uint32_t PCAPNG_BYTE_ORDER = 0x1a2b3c4d;
+constexpr uint32_t PCAPNG_IDB = 1;
+constexpr uint32_t PCAPNG_SPB = 3;
+constexpr uint32_t PCAPNG_EPB = 6;
+constexpr uint16_t LINKTYPE_ETHERNET = 1;
+constexpr size_t ETH_HDR_LEN = 14;
+constexpr uint32_t VLAN_HDR_LEN = 4;
+constexpr uint64_t REPLAY_MAX_SLEEP_US = 100000;
+
+static uint32_t load32(const uint8_t *p, bool swap) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? __builtin_bswap32(v) : v;
+}
+
+static uint16_t load16(const uint8_t *p, bool swap) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? __builtin_bswap16(v) : v;
+}
+
+PcapFile::~PcapFile() {
+    if (map != nullptr) {
+        munmap(map, map_size);
+    }
+}
+
+bool PcapFile::open(const std::string &path, uint32_t max_len, bool writable) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        perror(("cannot open " + path).c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < 24) {
+        std::cerr << path << ": not a capture file" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    file_size = st.st_size;
+    size_t page = sysconf(_SC_PAGESIZE);
+    map_size = (file_size + page - 1) & ~(page - 1);
+    // Заранее загружаем, чтобы отправка не ждала диск
+    void *addr = mmap(nullptr, map_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        perror("mmap capture failed");
+        map_size = 0;
+        return false;
+    }
+    map = static_cast<uint8_t *>(addr);
+
+    uint32_t magic = load32(map, false);
+    bool ok;
+    const char *format;
+    if (magic == PCAPNG_SHB) {
+        format = "pcapng";
+        ok = index_pcapng(max_len);
+    } else {
+        format = "pcap";
+        ok = index_pcap(max_len);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    if (index.empty()) {
+        std::cerr << path << ": no Ethernet frames to replay" << std::endl;
+        return false;
+    }
+    double span = (index.back().ts_ns - index.front().ts_ns) / 1e9;
+    std::cout << "Replaying " << path << " (" << format << "): " << index.size() << " frames, " << bytes
+              << " bytes over " << span << " s";
+    if (too_long > 0) {
+        std::cout << ", " << too_long << " frames longer than " << max_len << " bytes left out";
+    }
+    if (foreign > 0) {
+        std::cout << ", " << foreign << " non-Ethernet frames left out";
+    }
+    std::cout << std::endl;
+    if (truncated > 0) {
+        std::cout << truncated << " frames were captured with a snap length and are sent as captured" << std::endl;
+    }
+    if (cut_short) {
+        std::cerr << path << ": file ends inside a record, replaying the frames before it" << std::endl;
+    }
+    return true;
+}
+
+void PcapFile::add(uint64_t offset, uint32_t caplen, uint32_t origlen, uint64_t ts_ns, uint32_t max_len) {
+    if (caplen < ETH_HDR_LEN) {
+        foreign++;
+        return;
+    }
+    const uint8_t *frame = map + offset;
+    bool vlan = frame[12] == 0x81 && frame[13] == 0x00;
+    if (caplen > max_len + (vlan ? VLAN_HDR_LEN : 0)) {
+        too_long++;
+        return;
+    }
+    if (caplen < origlen) {
+        truncated++;
+    }
+    // Кадр с меньшей меткой времени отправляется сразу после предыдущего
+    if (!index.empty() && ts_ns < index.back().ts_ns) {
+        ts_ns = index.back().ts_ns;
+    }
+    index.push_back(PcapRecord{offset, caplen, ts_ns});
+    bytes += caplen;
+}
+
+bool PcapFile::index_pcap(uint32_t max_len) {
+    uint32_t magic = load32(map, false);
+    bool swap = magic == __builtin_bswap32(PCAP_MAGIC_US) || magic == __builtin_bswap32(PCAP_MAGIC_NS);
+    magic = swap ? __builtin_bswap32(magic) : magic;
+    if (magic != PCAP_MAGIC_US && magic != PCAP_MAGIC_NS) {
+        std::cerr << "Unknown capture format (magic " << std::hex << magic << std::dec << ")" << std::endl;
+        return false;
+    }
+    uint64_t ns_per_unit = magic == PCAP_MAGIC_NS ? 1 : 1000;
+    if (load32(map + 20, swap) != LINKTYPE_ETHERNET) {
+        std::cerr << "Capture link type " << load32(map + 20, swap) << " is not Ethernet" << std::endl;
+        return false;
+    }
+
+    size_t off = 24;
+    while (off + 16 <= file_size) {
+        uint64_t ts = load32(map + off, swap) * 1000000000ULL + load32(map + off + 4, swap) * ns_per_unit;
+        uint32_t caplen = load32(map + off + 8, swap);
+        uint32_t origlen = load32(map + off + 12, swap);
+        if (off + 16 + caplen > file_size) {
+            cut_short = true;
+            break;
+        }
+        add(off + 16, caplen, origlen, ts, max_len);
+        off += 16 + caplen;
+    }
+    return true;
+}
+
+// if_tsresol: 10^-v секунд или 2^-v при старшем бите
+static uint64_t pcapng_ts_ns(uint64_t ts, uint8_t resol) {
+    if (resol & 0x80) {
+        unsigned shift = resol & 0x7f;
+        if (shift >= 64) {
+            return 0;
+        }
+        uint64_t mask = shift ? (1ULL << shift) - 1 : ~0ULL;
+        return shift ? (ts >> shift) * 1000000000ULL + (((ts & mask) * 1000000000ULL) >> shift) : ts * 1000000000ULL;
+    }
+    uint64_t ns = ts;
+    for (unsigned e = resol; e < 9; e++) {
+        ns *= 10;
+    }
+    for (unsigned e = 9; e < resol; e++) {
+        ns /= 10;
+    }
+    return ns;
+}
+
+bool PcapFile::index_pcapng(uint32_t max_len) {
+    struct Interface {
+        bool ethernet;
+        uint8_t tsresol;
+    };
+    std::vector<Interface> interfaces;  // текущей секции
+    bool swap = false;
+    uint64_t last_ts = 0;
+
+    size_t off = 0;
+    while (off + 12 <= file_size) {
+        uint32_t type = load32(map + off, false);
+        if (type == PCAPNG_SHB) {
+            // Каждая секция задаёт свой порядок байт и интерфейсы
+            uint32_t order = load32(map + off + 8, false);
+            if (order != PCAPNG_BYTE_ORDER && order != __builtin_bswap32(PCAPNG_BYTE_ORDER)) {
+                std::cerr << "Bad pcapng byte order magic" << std::endl;
+                return false;
+            }
+            swap = order != PCAPNG_BYTE_ORDER;
+            interfaces.clear();
+        } else {
+            type = load32(map + off, swap);
+        }
+        uint32_t block_len = load32(map + off + 4, swap);
+        if (block_len < 12 || block_len % 4 != 0 || off + block_len > file_size) {
+            cut_short = true;
+            break;
+        }
+        const uint8_t *body = map + off + 8;
+        size_t body_len = block_len - 12;
+
+        if (type == PCAPNG_IDB && body_len >= 8) {
+            Interface itf{load16(body, swap) == LINKTYPE_ETHERNET, 6};
+            // Опции: код, длина, значение; if_tsresol - код 9
+            size_t opt = 8;
+            while (opt + 4 <= body_len) {
+                uint16_t code = load16(body + opt, swap);
+                uint16_t len = load16(body + opt + 2, swap);
+                if (code == 0) {
+                    break;
+                }
+                if (code == 9 && len >= 1 && opt + 5 <= body_len) {
+                    itf.tsresol = body[opt + 4];
+                }
+                opt += 4 + ((len + 3) & ~3u);
+            }
+            interfaces.push_back(itf);
+        } else if (type == PCAPNG_EPB && body_len >= 20) {
+            uint32_t if_id = load32(body, swap);
+            uint64_t ts = (static_cast<uint64_t>(load32(body + 4, swap)) << 32) | load32(body + 8, swap);
+            uint32_t caplen = load32(body + 12, swap);
+            uint32_t origlen = load32(body + 16, swap);
+            if (20 + static_cast<size_t>(caplen) > body_len) {
+                cut_short = true;
+                break;
+            }
+            if (if_id >= interfaces.size() || !interfaces[if_id].ethernet) {
+                foreign++;
+            } else {
+                last_ts = pcapng_ts_ns(ts, interfaces[if_id].tsresol);
+                add(body + 20 - map, caplen, origlen, last_ts, max_len);
+            }
+        } else if (type == PCAPNG_SPB && body_len >= 4) {
+            // Без метки времени: отправка сразу после предыдущего
+            uint32_t origlen = load32(body, swap);
+            uint32_t caplen = std::min<uint32_t>(origlen, body_len - 4);
+            if (interfaces.empty() || !interfaces[0].ethernet) {
+                foreign++;
+            } else {
+                add(body + 4 - map, caplen, origlen, last_ts, max_len);
+            }
+        }
+        off += block_len;
+    }
+    return true;
+}
+
+ReplayCursor::ReplayCursor(const PcapFile &pcap, unsigned worker_id, unsigned nb_workers, double speed,
+                           unsigned loops, uint64_t tsc_hz)
+    : records(pcap.records()), first(worker_id), stride(nb_workers), pos(worker_id), speed(speed), loops(loops),
+      cycles_per_ns(tsc_hz / 1e9) {}
+
+uint64_t ReplayCursor::due(const PcapRecord &r) const {
+    return loop_start + static_cast<uint64_t>((r.ts_ns - records.front().ts_ns) * cycles_per_ns / speed);
+}
+
+unsigned ReplayCursor::next(const PcapRecord **frames, unsigned max) {
+    if (first >= records.size() || max == 0) {
+        return 0;
+    }
+    if (pos >= records.size()) {
+        loops_done++;
+        if (loops != 0 && loops_done >= loops) {
+            return 0;
+        }
+        pos = first;
+        started = false;
+    }
+    if (!started) {
+        loop_start = __rdtsc();
+        started = true;
+    }
+
+    if (speed > 0) {
+        // Сон, пока до кадра далеко, затем активное ожидание
+        uint64_t target = due(records[pos]);
+        uint64_t sleep_margin = static_cast<uint64_t>(200000 * cycles_per_ns);
+        for (uint64_t now = __rdtsc(); now < target; now = __rdtsc()) {
+            if (stop_requested()) {
+                return 0;
+            }
+            if (target - now > sleep_margin) {
+                // Не дольше REPLAY_MAX_SLEEP_US, чтобы заметить остановку
+                usleep(std::min<uint64_t>((target - now - sleep_margin / 2) / cycles_per_ns / 1000, REPLAY_MAX_SLEEP_US));
+            } else {
+                _mm_pause();
+            }
+        }
+    } else if (stop_requested()) {
+        return 0;
+    }
+
+    uint64_t now = __rdtsc();
+    unsigned count = 0;
+    while (count < max && pos < records.size() && (speed <= 0 || count == 0 || due(records[pos]) <= now)) {
+        frames[count++] = &records[pos];
+        pos += stride;
+    }
+    return count;
+}
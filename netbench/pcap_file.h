@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Кадр записи: смещение, длина и время в наносекундах
+struct PcapRecord {
+    uint64_t offset;
+    uint32_t len;
+    uint64_t ts_ns;
+};
+
+// Отображение файла pcap или pcapng в память с индексом кадров Ethernet
+class PcapFile {
+public:
+    PcapFile() = default;
+    ~PcapFile();
+    PcapFile(const PcapFile &) = delete;
+    PcapFile &operator=(const PcapFile &) = delete;
+
+    // Открытие и индексация; кадры длиннее max_len пропускаются, writable - для DMA
+    bool open(const std::string &path, uint32_t max_len, bool writable = false);
+
+    const std::vector<PcapRecord> &records() const { return index; }
+    const uint8_t *data(const PcapRecord &r) const { return map + r.offset; }
+
+    // Всё отображение, для регистрации DMA
+    const uint8_t *map_base() const { return map; }
+    size_t map_length() const { return map_size; }
+
+    double mean_len() const { return index.empty() ? 0 : static_cast<double>(bytes) / index.size(); }
+
+private:
+    uint8_t *map = nullptr;
+    size_t map_size = 0;
+    size_t file_size = 0;
+    std::vector<PcapRecord> index;
+    uint64_t bytes = 0;
+    uint64_t too_long = 0;
+    uint64_t truncated = 0;   // записаны с snaplen
+    uint64_t foreign = 0;     // не Ethernet
+    bool cut_short = false;   // файл обрывается внутри записи
+
+    void add(uint64_t offset, uint32_t caplen, uint32_t origlen, uint64_t ts_ns, uint32_t max_len);
+    bool index_pcap(uint32_t max_len);
+    bool index_pcapng(uint32_t max_len);
+};
+
+// Доля воспроизведения для одного потока: кадр i идёт потоку i % nb_workers
+class ReplayCursor {
+public:
+    ReplayCursor(const PcapFile &pcap, unsigned worker_id, unsigned nb_workers, double speed, unsigned loops,
+                 uint64_t tsc_hz);
+
+    // До max кадров, время которых наступило; 0 в конце
+    unsigned next(const PcapRecord **frames, unsigned max);
+
+    // Возврат неотправленных кадров для повтора
+    void unget(unsigned count) { pos -= static_cast<size_t>(count) * stride; }
+
+private:
+    const std::vector<PcapRecord> &records;
+    size_t first;
+    size_t stride;
+    size_t pos;
+    double speed;
+    unsigned loops;
+    unsigned loops_done = 0;
+    double cycles_per_ns;
+    uint64_t loop_start = 0;
+    bool started = false;
+
+    uint64_t due(const PcapRecord &r) const;
+};
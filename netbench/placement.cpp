@@ -0,0 +1,183 @@
+#include "placement.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+constexpr size_t HUGEPAGE_SIZE = 2 * 1024 * 1024;
+
+// Задаётся configure_placement() до запуска потоков, дальше только чтение
+static struct {
+    bool active = false;
+    std::vector<int> worker_cpus;  // поток i работает на worker_cpus[i % size]
+    std::vector<int> helper_cpus;  // CPU для вспомогательных потоков
+    int mem_node = -1;             // -1: узел первого обращения
+    bool hugepages = false;
+} placement;
+
+bool parse_cpu_list(const std::string &list, std::vector<int> *cpus) {
+    std::stringstream ss(list);
+    std::string item;
+    try {
+        while (std::getline(ss, item, ',')) {
+            size_t dash = item.find('-');
+            int lo = std::stoi(item.substr(0, dash));
+            int hi = dash == std::string::npos ? lo : std::stoi(item.substr(dash + 1));
+            if (lo < 0 || lo > hi || hi >= CPU_SETSIZE) {
+                return false;
+            }
+            for (int cpu = lo; cpu <= hi; cpu++) {
+                cpus->push_back(cpu);
+            }
+        }
+    } catch (const std::exception &) {
+        return false;
+    }
+    return !cpus->empty();
+}
+
+int iface_numa_node(const std::string &ifname) {
+    std::ifstream file("/sys/class/net/" + ifname + "/device/numa_node");
+    int node = -1;
+    if (!(file >> node)) {
+        return -1;
+    }
+    return node;
+}
+
+// CPU узла NUMA по данным ядра
+static bool numa_node_cpus(int node, std::vector<int> *cpus) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    return std::getline(file, list) && parse_cpu_list(list, cpus);
+}
+
+static std::string format_cpus(const std::vector<int> &cpus) {
+    std::string out;
+    for (int cpu : cpus) {
+        out += (out.empty() ? "" : ",") + std::to_string(cpu);
+    }
+    return out;
+}
+
+static void pin_to(const std::vector<int> &cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        std::cerr << "pthread_setaffinity_np(" << format_cpus(cpus) << ") failed: " << strerror(err) << std::endl;
+    }
+}
+
+void configure_buffers(const Options &opts) {
+    placement.hugepages = opts.hugepages;
+    placement.mem_node = iface_numa_node(opts.iface);
+}
+
+bool configure_placement(const Options &opts, unsigned nb_workers) {
+    configure_buffers(opts);
+
+    std::vector<int> cpus;
+    if (!opts.cpus.empty()) {
+        if (!parse_cpu_list(opts.cpus, &cpus)) {
+            std::cerr << "Bad --cpus: " << opts.cpus << " (expected a list like 0-3,8)" << std::endl;
+            return false;
+        }
+    } else if (opts.numa_node >= 0) {
+        if (!numa_node_cpus(opts.numa_node, &cpus)) {
+            std::cerr << "No CPUs found for NUMA node " << opts.numa_node << std::endl;
+            return false;
+        }
+    }
+
+    if (!cpus.empty()) {
+        placement.active = true;
+        // Рабочим потокам первые CPU, вспомогательным остальные
+        size_t nb_worker_cpus = std::min<size_t>(nb_workers, cpus.size());
+        placement.worker_cpus.assign(cpus.begin(), cpus.begin() + nb_worker_cpus);
+        if (cpus.size() > nb_worker_cpus) {
+            placement.helper_cpus.assign(cpus.begin() + nb_worker_cpus, cpus.end());
+        } else {
+            placement.helper_cpus = cpus;
+        }
+        if (cpus.size() < nb_workers) {
+            std::cerr << "Only " << cpus.size() << " CPUs for " << nb_workers << " workers, some share a CPU" << std::endl;
+        }
+        std::cout << "Workers on CPUs " << format_cpus(placement.worker_cpus)
+                  << ", helper threads on CPUs " << format_cpus(placement.helper_cpus) << std::endl;
+    }
+
+    if (placement.mem_node >= 0) {
+        std::cout << "Frame buffers on NUMA node " << placement.mem_node << " (" << opts.iface << ")" << std::endl;
+        if (opts.numa_node >= 0 && opts.numa_node != placement.mem_node) {
+            std::cout << "Threads on NUMA node " << opts.numa_node << ": all traffic crosses the socket interconnect" << std::endl;
+        }
+    }
+    return true;
+}
+
+bool placement_active() {
+    return placement.active;
+}
+
+void pin_worker(unsigned worker_id) {
+    if (placement.active) {
+        pin_to({placement.worker_cpus[worker_id % placement.worker_cpus.size()]});
+    }
+}
+
+void pin_helper() {
+    if (placement.active) {
+        pin_to(placement.helper_cpus);
+    }
+}
+
+FrameBuffer::FrameBuffer(size_t size) : length(size) {
+    void *map = MAP_FAILED;
+    if (placement.hugepages) {
+        map_size = (size + HUGEPAGE_SIZE - 1) & ~(HUGEPAGE_SIZE - 1);
+        map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugepages = map != MAP_FAILED;
+        static std::atomic<bool> warned{false};
+        if (map == MAP_FAILED && !warned.exchange(true)) {
+            std::cerr << "No hugepages available for frame buffers, falling back to 4K pages" << std::endl;
+        }
+    }
+    if (map == MAP_FAILED) {
+        map_size = size;
+        map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {
+            perror("mmap frame buffer failed");
+            map_size = length = 0;
+            return;
+        }
+    }
+
+    // Привязка до первого обращения к страницам; MPOL_PREFERRED, а не строгая
+    if (placement.mem_node >= 0 && placement.mem_node < 64) {
+        unsigned long nodemask = 1UL << placement.mem_node;
+        if (syscall(SYS_mbind, map, map_size, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8 + 1, 0) < 0) {
+            perror("mbind frame buffer failed");
+        }
+    }
+    memset(map, 0, map_size);
+    area = static_cast<uint8_t *>(map);
+}
+
+FrameBuffer::~FrameBuffer() {
+    if (area != nullptr) {
+        munmap(area, map_size);
+    }
+}
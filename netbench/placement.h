@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "options.h"
+
+// Размещение потоков и буферов: --cpus, --numa-node, --hugepages
+bool configure_placement(const Options &opts, unsigned nb_workers);
+
+// Только буферы (--hugepages, узел NIC), для выделения в setup() движка
+void configure_buffers(const Options &opts);
+
+// true, если задан --cpus или --numa-node
+bool placement_active();
+
+void pin_worker(unsigned worker_id);
+void pin_helper();
+
+// Разбор списка CPU "0-3,8,10-11"
+bool parse_cpu_list(const std::string &list, std::vector<int> *cpus);
+
+// Узел NUMA интерфейса, -1 если неизвестен
+int iface_numa_node(const std::string &ifname);
+
+// Буфер кадров на узле NIC; data() равен nullptr при ошибке
+class FrameBuffer {
+public:
+    explicit FrameBuffer(size_t size);
+    ~FrameBuffer();
+    FrameBuffer(const FrameBuffer &) = delete;
+    FrameBuffer &operator=(const FrameBuffer &) = delete;
+
+    uint8_t *data() const { return area; }
+    size_t size() const { return length; }
+    bool in_hugepages() const { return hugepages; }
+
+private:
+    uint8_t *area = nullptr;
+    size_t length = 0;
+    size_t map_size = 0;
+    bool hugepages = false;
+};
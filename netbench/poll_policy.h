@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <sys/prctl.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "options.h"
+#include "stats.h"
+
+// --poll: поведение цикла приёма при пустом опросе
+enum class PollMode {
+    Busy,       // сразу опрашивать снова, ядро загружено на 100%
+    Adaptive,   // опрос, затем pause, затем всё более долгий сон
+    Interrupt,  // как adaptive, но с ожиданием в ядре вместо долгого сна
+};
+
+// Пустых опросов до начала ожидания
+constexpr unsigned POLL_SPIN_POLLS = 64;
+// Шаги по 1, 2, 4 ... 1024 pause, затем сон 1, 2, 4 ... мкс
+constexpr unsigned POLL_PAUSE_STEPS = 11;
+
+// Разбор --poll; без него busy с --no-sleep, иначе adaptive
+inline bool parse_poll_mode(const Options &opts, PollMode *mode) {
+    if (opts.poll.empty()) {
+        *mode = opts.use_sleep ? PollMode::Adaptive : PollMode::Busy;
+    } else if (opts.poll == "busy") {
+        *mode = PollMode::Busy;
+    } else if (opts.poll == "adaptive") {
+        *mode = PollMode::Adaptive;
+    } else if (opts.poll == "interrupt") {
+        *mode = PollMode::Interrupt;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Ожидание потока приёма при простое и учёт времени по состояниям
+class PollPolicy {
+public:
+    PollPolicy(PollMode mode, unsigned max_sleep_us, WorkerStats &ws)
+        : mode(mode), max_sleep_us(std::max(max_sleep_us, 1u)), ws(ws), last(__rdtsc()) {
+        if (mode != PollMode::Busy) {
+            // Стандартный timer slack 50 мкс съел бы короткие паузы
+            prctl(PR_SET_TIMERSLACK, 1000UL);
+        }
+    }
+
+    // Вызывается после каждого опроса; wait() нужен только в режиме interrupt
+    template <typename Wait>
+    void after_poll(unsigned nb_rx, const Wait &wait) {
+        charge(nb_rx > 0 ? POLL_BUSY : POLL_SPIN);
+        if (nb_rx == 0) {
+            ws.add_empty_poll();
+        }
+        if (nb_rx > 0 || mode == PollMode::Busy) {
+            empty_polls = 0;
+            return;
+        }
+
+        if (empty_polls < UINT32_MAX) {
+            empty_polls++;
+        }
+        if (empty_polls <= POLL_SPIN_POLLS) {
+            return;
+        }
+        unsigned step = empty_polls - POLL_SPIN_POLLS - 1;
+        if (step < POLL_PAUSE_STEPS) {
+            for (unsigned i = 0; i < (1u << step); i++) {
+                _mm_pause();
+            }
+            charge(POLL_PAUSE);
+            return;
+        }
+        unsigned sleep_us = 1u << std::min(step - POLL_PAUSE_STEPS, 20u);
+        if (sleep_us >= max_sleep_us && mode == PollMode::Interrupt) {
+            wait();
+            charge(POLL_WAIT);
+            return;
+        }
+        usleep(std::min(sleep_us, max_sleep_us));
+        charge(POLL_SLEEP);
+    }
+
+    // Учёт времени с последнего вызова, в конце цикла
+    void finish() { charge(POLL_SPIN); }
+
+private:
+    PollMode mode;
+    unsigned max_sleep_us;
+    WorkerStats &ws;
+    uint64_t last;
+    unsigned empty_polls = 0;
+
+    void charge(PollState state) {
+        uint64_t now = __rdtsc();
+        ws.add_poll_cycles(state, now - last);
+        last = now;
+    }
+};
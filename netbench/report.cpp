@@ -0,0 +1,279 @@
+#include "report.h"
+
+#include <algorithm>
+#include <array>
+#include <iomanip>
+#include <string>
+#include <utility>
+
+Reporter::Reporter(Stats &stats, const std::vector<StreamTable> *streams, ResultLog *log, DeviceCounterSource device)
+    : stats(stats), streams(streams), log(log), device(std::move(device)) {
+    for (size_t i = 0; i < stats.workers.size(); i++) {
+        last_workers.push_back(stats.snapshot(i));
+        last_lost.push_back(lost(i));
+    }
+    last_total_lost = total_lost();
+    if (this->device) {
+        this->device(&device_start);
+    }
+    device_last = device_start;
+}
+
+// Изменение счётчика i с base; при сбросе считается от нуля
+static uint64_t counter_delta(const DeviceCounters &now, const DeviceCounters &base, size_t i) {
+    if (i < base.size() && base[i].name == now[i].name && now[i].value >= base[i].value) {
+        return now[i].value - base[i].value;
+    }
+    return now[i].value;
+}
+
+static std::array<uint64_t, LOSS_KINDS> loss_totals(const DeviceCounters &now, const DeviceCounters &base) {
+    std::array<uint64_t, LOSS_KINDS> totals{};
+    for (size_t i = 0; i < now.size(); i++) {
+        if (now[i].kind != CounterKind::Info) {
+            totals[loss_index(now[i].kind)] += counter_delta(now, base, i);
+        }
+    }
+    return totals;
+}
+
+// Потери по номерам кадров для одного потока приёма
+uint64_t Reporter::lost(size_t worker) const {
+    if (!streams) {
+        return 0;
+    }
+    return stream_totals(&(*streams)[worker], 1).lost;
+}
+
+uint64_t Reporter::total_lost() const {
+    if (!streams) {
+        return 0;
+    }
+    return stream_totals(streams->data(), streams->size()).lost;
+}
+
+static IntervalSample interval_sample(const StatsSnapshot &now, const StatsSnapshot &prev, uint64_t lost, uint64_t prev_lost) {
+    double interval = std::chrono::duration<double>(now.time - prev.time).count();
+    IntervalSample s;
+    s.packets = now.packets - prev.packets;
+    s.bytes = now.bytes - prev.bytes;
+    // Опоздавшие кадры могут уменьшить потери
+    s.drops = now.drops - prev.drops + (lost > prev_lost ? lost - prev_lost : 0);
+    if (interval > 0) {
+        s.pps = s.packets / interval;
+        s.bps = s.bytes * 8 / interval;
+        s.drops_per_sec = s.drops / interval;
+    }
+    return s;
+}
+
+void Reporter::log_interval(const StatsSnapshot &now, const StatsSnapshot &prev) {
+    double time_s = std::chrono::duration<double>(now.time - stats.start_time).count();
+    uint64_t monotonic_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time.time_since_epoch()).count();
+
+    for (size_t i = 0; i < stats.workers.size(); i++) {
+        StatsSnapshot worker_now = stats.snapshot(i);
+        uint64_t worker_lost = lost(i);
+        log->sample(time_s, monotonic_ns, i, interval_sample(worker_now, last_workers[i], worker_lost, last_lost[i]));
+        last_workers[i] = worker_now;
+        last_lost[i] = worker_lost;
+    }
+
+    uint64_t lost_now = total_lost();
+    IntervalSample total = interval_sample(now, prev, lost_now, last_total_lost);
+    last_total_lost = lost_now;
+    log->sample(time_s, monotonic_ns, -1, total);
+    pps_series.push_back(total.pps);
+    bps_series.push_back(total.bps);
+    drops_series.push_back(total.drops_per_sec);
+}
+
+void Reporter::interval(std::ostream &os) {
+    StatsSnapshot now = stats.snapshot();
+    if (log) {
+        log_interval(now, stats.last);
+    }
+    double interval = std::chrono::duration<double>(now.time - stats.last.time).count();
+    double packets_per_sec = interval > 0 ? (now.packets - stats.last.packets) / interval : 0;
+    double bytes_per_sec = interval > 0 ? (now.bytes - stats.last.bytes) / interval : 0;
+    double goodput = interval > 0 ? (now.good_bytes - stats.last.good_bytes) / interval : 0;
+    stats.last = now;
+    DeviceCounters device_now;
+    if (device) {
+        device(&device_now);
+    }
+
+    os << "\rStats: "
+       << format_unit(now.packets) << "-packets, "
+       << format_unit(now.bytes) << "bytes, "
+       << format_unit(packets_per_sec) << "-packets/s, "
+       << format_unit(bytes_per_sec) << "b/s";
+    if (streams) {
+        StreamTotals totals = stream_totals(streams->data(), streams->size());
+        os << ", goodput " << format_unit(goodput) << "b/s, loss "
+           << std::fixed << std::setprecision(4) << totals.loss_rate() * 100 << "%";
+    }
+    // Только если были потери ниже приложения
+    std::array<uint64_t, LOSS_KINDS> device_loss = loss_totals(device_now, device_last);
+    for (size_t k = 0; k < LOSS_KINDS; k++) {
+        if (device_loss[k] > 0) {
+            os << ", " << LOSS_KIND_NAMES[k] << " +" << device_loss[k];
+        }
+    }
+    device_last = std::move(device_now);
+    os << "   " << std::flush;
+}
+
+// Кадры теста по размерам, пустые диапазоны пропускаются
+void Reporter::print_size_report(std::ostream &os) const {
+    std::array<uint64_t, SIZE_BUCKETS> counts{};
+    uint64_t total = 0;
+    for (const WorkerStats &ws : stats.workers) {
+        for (size_t b = 0; b < SIZE_BUCKETS; b++) {
+            counts[b] += ws.sizes[b].load(std::memory_order_relaxed);
+        }
+    }
+    for (uint64_t count : counts) {
+        total += count;
+    }
+    if (total == 0) {
+        return;
+    }
+    os << "Frame sizes (on the wire):";
+    const char *sep = " ";
+    for (size_t b = 0; b < SIZE_BUCKETS; b++) {
+        if (counts[b] == 0) {
+            continue;
+        }
+        os << sep << SIZE_BUCKET_NAMES[b] << ": " << counts[b] << " ("
+           << std::fixed << std::setprecision(2) << 100.0 * counts[b] / total << "%)";
+        sep = ", ";
+    }
+    os << std::endl;
+}
+
+// Изменившиеся счётчики устройства и потери по видам
+void Reporter::print_device_report(std::ostream &os, std::vector<std::pair<std::string, uint64_t>> *logged) const {
+    DeviceCounters now;
+    if (device) {
+        device(&now);
+    }
+    if (now.empty()) {
+        return;
+    }
+
+    os << "Device counters:";
+    const char *sep = " ";
+    for (size_t i = 0; i < now.size(); i++) {
+        uint64_t delta = counter_delta(now, device_start, i);
+        logged->emplace_back(now[i].name, delta);
+        if (delta > 0) {
+            os << sep << now[i].name << " " << delta;
+            sep = ", ";
+        }
+    }
+    if (*sep == ' ') {
+        os << " no change";
+    }
+    os << std::endl;
+
+    std::array<uint64_t, LOSS_KINDS> loss = loss_totals(now, device_start);
+    os << "Lost below the application:";
+    for (size_t k = 0; k < LOSS_KINDS; k++) {
+        os << (k ? ", " : " ") << LOSS_KIND_NAMES[k] << " " << loss[k];
+        std::string causes;
+        for (size_t i = 0; i < now.size(); i++) {
+            uint64_t delta = counter_delta(now, device_start, i);
+            if (now[i].kind != CounterKind::Info && loss_index(now[i].kind) == k && delta > 0) {
+                causes += (causes.empty() ? "" : ", ") + now[i].name + " " + std::to_string(delta);
+            }
+        }
+        if (!causes.empty()) {
+            os << " (" << causes << ")";
+        }
+    }
+    os << std::endl;
+}
+
+// Доля времени потока в каждом состоянии опроса
+static std::array<double, POLL_STATES> poll_shares(const WorkerStats &ws) {
+    std::array<double, POLL_STATES> shares{};
+    uint64_t total = 0;
+    for (const auto &cycles : ws.poll_cycles) {
+        total += cycles.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; total > 0 && i < POLL_STATES; i++) {
+        shares[i] = static_cast<double>(ws.poll_cycles[i].load(std::memory_order_relaxed)) / total;
+    }
+    return shares;
+}
+
+static void print_poll_shares(std::ostream &os, const std::array<double, POLL_STATES> &shares) {
+    for (size_t i = 0; i < POLL_STATES; i++) {
+        os << (i ? ", " : "") << POLL_STATE_NAMES[i] << " " << std::fixed << std::setprecision(2) << shares[i] * 100 << "%";
+    }
+    // Спящие потоки освобождают ядро
+    double on_cpu = shares[POLL_BUSY] + shares[POLL_SPIN] + shares[POLL_PAUSE];
+    os << "; on CPU " << on_cpu * 100 << "%";
+}
+
+void Reporter::summary(std::ostream &os, const char *role) const {
+    os << std::endl;
+    os << role << " stopped by user." << std::endl;
+
+    StatsSnapshot totals = stats.snapshot();
+    os << "Total messages: " << totals.packets << std::endl;
+    os << "Total bytes: " << totals.bytes << " bytes" << std::endl;
+    if (streams) {
+        os << "Benchmark frames: " << totals.good_packets << ", " << totals.good_bytes << " bytes" << std::endl;
+        print_stream_report(os, streams->data(), streams->size());
+        print_size_report(os);
+    }
+    if (totals.drops > 0) {
+        os << "Dropped frames: " << totals.drops << std::endl;
+    }
+    std::vector<std::pair<std::string, uint64_t>> device_totals;
+    print_device_report(os, &device_totals);
+
+    // Строки по потокам
+    bool polled = std::any_of(stats.workers.begin(), stats.workers.end(),
+                              [](const WorkerStats &ws) { return ws.empty_polls > 0; });
+    std::array<double, POLL_STATES> mean_shares{};
+    if (stats.workers.size() > 1 || polled) {
+        for (size_t i = 0; i < stats.workers.size(); i++) {
+            const WorkerStats &ws = stats.workers[i];
+            std::array<double, POLL_STATES> shares = poll_shares(ws);
+            os << "Worker " << i << ": " << ws.packets << " packets, " << ws.bytes << " bytes";
+            if (ws.empty_polls > 0) {
+                os << ", " << ws.empty_polls << " empty polls";
+            }
+            if (polled) {
+                os << ", ";
+                print_poll_shares(os, shares);
+            }
+            os << std::endl;
+            for (size_t s = 0; s < POLL_STATES; s++) {
+                mean_shares[s] += shares[s] / stats.workers.size();
+            }
+        }
+    }
+    if (polled) {
+        os << "Receive loop time: ";
+        print_poll_shares(os, mean_shares);
+        os << std::endl;
+    }
+
+    if (log) {
+        IntervalSample run;
+        run.packets = totals.packets;
+        run.bytes = totals.bytes;
+        run.drops = totals.drops + total_lost();
+        double duration = std::chrono::duration<double>(totals.time - stats.start_time).count();
+        std::vector<std::pair<const char *, double>> poll_s;
+        for (size_t i = 0; polled && i < POLL_STATES; i++) {
+            poll_s.emplace_back(POLL_STATE_NAMES[i], mean_shares[i] * stats.workers.size() * duration);
+        }
+        log->summary(role, duration, run, summarize_rates(pps_series), summarize_rates(bps_series),
+                     summarize_rates(drops_series), poll_s, device_totals);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include "bench_proto.h"
+#include "device_counters.h"
+#include "results.h"
+#include "stats.h"
+
+// Вывод статистики: строка за каждый интервал и итоги при завершении
+class Reporter {
+public:
+    explicit Reporter(Stats &stats, const std::vector<StreamTable> *streams = nullptr, ResultLog *log = nullptr,
+                      DeviceCounterSource device = nullptr);
+
+    // Итоги и скорость с прошлого вызова
+    void interval(std::ostream &os);
+
+    // role - "Sender" или "Receiver"
+    void summary(std::ostream &os, const char *role) const;
+
+private:
+    Stats &stats;
+    const std::vector<StreamTable> *streams;
+    ResultLog *log;
+    DeviceCounterSource device;
+    DeviceCounters device_start, device_last;
+
+    // Состояние прошлого интервала и ряды по секундам, только для лога
+    std::vector<StatsSnapshot> last_workers;
+    std::vector<uint64_t> last_lost;
+    uint64_t last_total_lost = 0;
+    std::vector<double> pps_series, bps_series, drops_series;
+
+    uint64_t lost(size_t worker) const;
+    uint64_t total_lost() const;
+    void print_size_report(std::ostream &os) const;
+    void print_device_report(std::ostream &os, std::vector<std::pair<std::string, uint64_t>> *logged) const;
+    void log_interval(const StatsSnapshot &now, const StatsSnapshot &prev);
+};
@@ -0,0 +1,138 @@
+#include "results.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+// Процентиль отсортированных значений
+static double percentile(const std::vector<double> &sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+RateSummary summarize_rates(std::vector<double> values) {
+    RateSummary summary;
+    summary.count = values.size();
+    if (values.empty()) {
+        return summary;
+    }
+    std::sort(values.begin(), values.end());
+
+    double sum = 0;
+    for (double v : values) {
+        sum += v;
+    }
+    summary.mean = sum / values.size();
+    double sq = 0;
+    for (double v : values) {
+        sq += (v - summary.mean) * (v - summary.mean);
+    }
+    summary.stddev = values.size() > 1 ? std::sqrt(sq / (values.size() - 1)) : 0;
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.p50 = percentile(values, 50);
+    summary.p90 = percentile(values, 90);
+    summary.p99 = percentile(values, 99);
+    return summary;
+}
+
+bool parse_output_format(const std::string &name, ResultLog::Format *format) {
+    if (name == "json") {
+        *format = ResultLog::Format::Json;
+    } else if (name == "csv") {
+        *format = ResultLog::Format::Csv;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ResultLog::begin(const char *role, size_t nb_workers) {
+    out << std::fixed << std::setprecision(3);
+    if (format == Format::Json) {
+        out << "{\"type\":\"run\",\"role\":\"" << role << "\",\"workers\":" << nb_workers << "}\n";
+    } else {
+        out << "type,time_s,monotonic_ns,worker,packets,bytes,drops,pps,bps,drops_per_s\n";
+    }
+    out.flush();
+}
+
+void ResultLog::sample(double time_s, uint64_t monotonic_ns, int worker, const IntervalSample &s) {
+    if (format == Format::Json) {
+        out << "{\"type\":\"sample\",\"time_s\":" << time_s << ",\"monotonic_ns\":" << monotonic_ns
+            << ",\"worker\":";
+        if (worker < 0) {
+            out << "\"all\"";
+        } else {
+            out << worker;
+        }
+        out << ",\"packets\":" << s.packets << ",\"bytes\":" << s.bytes << ",\"drops\":" << s.drops
+            << ",\"pps\":" << s.pps << ",\"bps\":" << s.bps << ",\"drops_per_s\":" << s.drops_per_sec << "}\n";
+    } else {
+        out << "sample," << time_s << "," << monotonic_ns << ",";
+        if (worker < 0) {
+            out << "all";
+        } else {
+            out << worker;
+        }
+        out << "," << s.packets << "," << s.bytes << "," << s.drops << ","
+            << s.pps << "," << s.bps << "," << s.drops_per_sec << "\n";
+    }
+    // Скрипты читают файл на ходу, поэтому сброс каждый интервал
+    out.flush();
+}
+
+static void write_json_rates(std::ostream &out, const char *name, const RateSummary &r) {
+    out << ",\"" << name << "\":{\"mean\":" << r.mean << ",\"stddev\":" << r.stddev << ",\"min\":" << r.min
+        << ",\"max\":" << r.max << ",\"p50\":" << r.p50 << ",\"p90\":" << r.p90 << ",\"p99\":" << r.p99 << "}";
+}
+
+void ResultLog::summary(const char *role, double duration_s, const IntervalSample &totals,
+                        const RateSummary &pps, const RateSummary &bps, const RateSummary &drops,
+                        const std::vector<std::pair<const char *, double>> &poll_s,
+                        const std::vector<std::pair<std::string, uint64_t>> &device) {
+    if (format == Format::Json) {
+        out << "{\"type\":\"summary\",\"role\":\"" << role << "\",\"duration_s\":" << duration_s
+            << ",\"intervals\":" << pps.count << ",\"packets\":" << totals.packets
+            << ",\"bytes\":" << totals.bytes << ",\"drops\":" << totals.drops;
+        write_json_rates(out, "pps", pps);
+        write_json_rates(out, "bps", bps);
+        write_json_rates(out, "drops_per_s", drops);
+        if (!poll_s.empty()) {
+            out << ",\"poll_s\":{";
+            for (size_t i = 0; i < poll_s.size(); i++) {
+                out << (i ? "," : "") << "\"" << poll_s[i].first << "\":" << poll_s[i].second;
+            }
+            out << "}";
+        }
+        if (!device.empty()) {
+            out << ",\"device\":{";
+            for (size_t i = 0; i < device.size(); i++) {
+                out << (i ? "," : "") << "\"" << device[i].first << "\":" << device[i].second;
+            }
+            out << "}";
+        }
+        out << "}\n";
+    } else {
+        // Строка итогов, затем статистика по секундам
+        out << "total," << duration_s << ",,all," << totals.packets << "," << totals.bytes << ","
+            << totals.drops << ",,,\n";
+        const std::pair<const char *, double RateSummary::*> stats[] = {
+            {"mean", &RateSummary::mean}, {"stddev", &RateSummary::stddev},
+            {"min", &RateSummary::min}, {"max", &RateSummary::max},
+            {"p50", &RateSummary::p50}, {"p90", &RateSummary::p90}, {"p99", &RateSummary::p99},
+        };
+        for (const auto &[name, field] : stats) {
+            out << name << ",,,all,,,," << pps.*field << "," << bps.*field << "," << drops.*field << "\n";
+        }
+        // Время потоков по состояниям опроса
+        for (const auto &[state, seconds] : poll_s) {
+            out << "poll_" << state << "," << seconds << ",,all,,,,,,\n";
+        }
+        // Счётчики устройства в колонке packets
+        for (const auto &[name, value] : device) {
+            out << "dev_" << name << ",,,all," << value << ",,,,,\n";
+        }
+    }
+    out.flush();
+}
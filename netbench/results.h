@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Счётчики и скорость за интервал для процесса или потока
+struct IntervalSample {
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t drops = 0;
+    double pps = 0;
+    double bps = 0;
+    double drops_per_sec = 0;
+};
+
+// Среднее, разброс и процентили скорости по секундам
+struct RateSummary {
+    size_t count = 0;
+    double mean = 0;
+    double stddev = 0;
+    double min = 0;
+    double max = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+};
+
+RateSummary summarize_rates(std::vector<double> values);
+
+// Запись результатов --output json|csv: интервалы и итоги
+class ResultLog {
+public:
+    enum class Format { Json, Csv };
+
+    ResultLog(Format format, const std::string &path) : format(format), out(path) {}
+
+    bool is_open() const { return out.is_open(); }
+
+    void begin(const char *role, size_t nb_workers);
+    // worker < 0 - весь процесс
+    void sample(double time_s, uint64_t monotonic_ns, int worker, const IntervalSample &s);
+    // poll_s - время по состояниям опроса, device - изменение счётчиков
+    void summary(const char *role, double duration_s, const IntervalSample &totals,
+                 const RateSummary &pps, const RateSummary &bps, const RateSummary &drops,
+                 const std::vector<std::pair<const char *, double>> &poll_s = {},
+                 const std::vector<std::pair<std::string, uint64_t>> &device = {});
+
+private:
+    Format format;
+    std::ofstream out;
+};
+
+// Разбор "json" или "csv"
+bool parse_output_format(const std::string &name, ResultLog::Format *format);
@@ -0,0 +1,126 @@
+#include "runner.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "placement.h"
+#include "report.h"
+
+static std::atomic<bool> force_quit{false};
+
+bool stop_requested() {
+    return force_quit.load(std::memory_order_relaxed);
+}
+
+void request_stop() {
+    force_quit = true;
+}
+
+static void signal_handler(int signum) {
+    if (signum == SIGINT || signum == SIGTERM) {
+        std::cout << "\nSignal " << signum << " received, preparing to exit..." << std::endl;
+        force_quit = true;
+    }
+}
+
+void launch_threads(unsigned nb_workers, const WorkerBody &body) {
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < nb_workers; i++) {
+        threads.emplace_back([&body, i] {
+            pin_worker(i);
+            body(i);
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
+// Вывод статистики раз в секунду до остановки потоков
+static std::thread start_reporter(Reporter &reporter) {
+    return std::thread([&reporter] {
+        pin_helper();
+        while (!stop_requested()) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (stop_requested()) {
+                break;  // неполный интервал исказил бы скорость
+            }
+            reporter.interval(std::cout);
+        }
+    });
+}
+
+// Открытие файла --output; nullptr без --output
+static std::unique_ptr<ResultLog> open_result_log(const Options &opts) {
+    if (opts.output.empty()) {
+        return nullptr;
+    }
+    ResultLog::Format format;
+    if (!parse_output_format(opts.output, &format)) {
+        std::cerr << "Unknown output format: " << opts.output << " (expected json or csv)" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::string path = opts.output_file.empty() ? "results." + opts.output : opts.output_file;
+    auto log = std::make_unique<ResultLog>(format, path);
+    if (!log->is_open()) {
+        perror(("cannot open " + path).c_str());
+        exit(EXIT_FAILURE);
+    }
+    return log;
+}
+
+int run_engine(TxEngine &engine, const Options &opts) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    std::unique_ptr<ResultLog> log = open_result_log(opts);
+    if (!engine.setup() || !configure_placement(opts, engine.nb_workers())) {
+        return EXIT_FAILURE;
+    }
+
+    Stats stats;
+    stats.start(engine.nb_workers());
+    Reporter reporter(stats, nullptr, log.get(), [&engine](DeviceCounters *c) { engine.device_counters(c); });
+    if (log) {
+        log->begin("Sender", engine.nb_workers());
+    }
+    std::thread reporter_thread = start_reporter(reporter);
+
+    engine.launch([&](unsigned id) { engine.transmit(id, stats.workers[id]); });
+    request_stop();
+
+    reporter_thread.join();
+    reporter.summary(std::cout, "Sender");
+    engine.report(std::cout);
+    return 0;
+}
+
+int run_engine(RxEngine &engine, const Options &opts) {
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+    std::unique_ptr<ResultLog> log = open_result_log(opts);
+    if (!engine.setup() || !configure_placement(opts, engine.nb_workers())) {
+        return EXIT_FAILURE;
+    }
+
+    Stats stats;
+    stats.start(engine.nb_workers());
+    std::vector<StreamTable> streams(engine.nb_workers());
+    Reporter reporter(stats, &streams, log.get(), [&engine](DeviceCounters *c) { engine.device_counters(c); });
+    if (log) {
+        log->begin("Receiver", engine.nb_workers());
+    }
+    std::thread reporter_thread = start_reporter(reporter);
+
+    engine.launch([&](unsigned id) { engine.receive(id, stats.workers[id], streams[id]); });
+    request_stop();
+
+    reporter_thread.join();
+    reporter.summary(std::cout, "Receiver");
+    engine.report(std::cout);
+    return 0;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "engine.h"
+#include "options.h"
+
+// Общий цикл запуска: сигналы, настройка, потоки и итоговый отчёт; возвращает код выхода
+int run_engine(TxEngine &engine, const Options &opts);
+int run_engine(RxEngine &engine, const Options &opts);
+
+// Флаг остановки, ставится обработчиком сигнала или потоком при ошибке
+bool stop_requested();
+void request_stop();
@@ -0,0 +1,121 @@
+#include "size_schedule.h"
+
+#include <iostream>
+#include <net/ethernet.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+
+// Кратчайшее расписание по списку весов
+constexpr size_t SCHEDULE_MIN_LEN = 1024;
+constexpr size_t SCHEDULE_MAX_LEN = 1 << 20;
+
+// Простой IMIX: IP-пакеты 40, 576 и 1500 в соотношении 7:4:1
+static const std::pair<size_t, size_t> IMIX[] = {{40, 7}, {576, 4}, {1500, 1}};
+
+// Разбор "SIZE[:WEIGHT],..." или "uniform:LO-HI"
+static bool parse_weights(const std::string &spec, std::vector<std::pair<size_t, size_t>> *weights) {
+    try {
+        if (spec.rfind("uniform:", 0) == 0) {
+            std::string range = spec.substr(8);
+            size_t dash = range.find('-');
+            if (dash == std::string::npos) {
+                return false;
+            }
+            size_t lo = std::stoul(range.substr(0, dash));
+            size_t hi = std::stoul(range.substr(dash + 1));
+            if (lo > hi || hi > UINT16_MAX) {
+                return false;
+            }
+            for (size_t size = lo; size <= hi; size++) {
+                weights->emplace_back(size, 1);
+            }
+            return true;
+        }
+
+        std::stringstream ss(spec);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t colon = item.find(':');
+            size_t size = std::stoul(item.substr(0, colon));
+            size_t weight = colon == std::string::npos ? 1 : std::stoul(item.substr(colon + 1));
+            if (size > UINT16_MAX) {
+                return false;
+            }
+            if (weight > 0) {
+                weights->emplace_back(size, weight);
+            }
+        }
+    } catch (const std::exception &) {
+        return false;
+    }
+    return !weights->empty();
+}
+
+bool SizeSchedule::build(const Options &opts, size_t size_offset, size_t min_frame, size_t max_frame, SizeSchedule *out) {
+    std::vector<std::pair<size_t, size_t>> weights;
+    if (opts.size_dist.empty()) {
+        weights.emplace_back(opts.size + size_offset, 1);
+    } else if (opts.size_dist == "imix") {
+        for (const auto &[size, weight] : IMIX) {
+            weights.emplace_back(size + sizeof(struct ether_header), weight);
+        }
+    } else {
+        if (!parse_weights(opts.size_dist, &weights)) {
+            std::cerr << "Bad --size-dist: " << opts.size_dist
+                      << " (expected imix, uniform:LO-HI or SIZE[:WEIGHT],...)" << std::endl;
+            return false;
+        }
+        for (auto &entry : weights) {
+            entry.first += size_offset;
+        }
+    }
+
+    size_t total_weight = 0;
+    for (const auto &entry : weights) {
+        total_weight += entry.second;
+    }
+    if (total_weight > SCHEDULE_MAX_LEN) {
+        std::cerr << "Bad --size-dist: weights add up to more than " << SCHEDULE_MAX_LEN << std::endl;
+        return false;
+    }
+
+    size_t repeats = (SCHEDULE_MIN_LEN + total_weight - 1) / total_weight;
+    out->sizes.clear();
+    out->sizes.reserve(repeats * total_weight);
+    double sum = 0;
+    std::string raised, lowered;  // изменённые размеры
+    for (const auto &[size, weight] : weights) {
+        uint16_t frame_len = std::clamp(size, min_frame, max_frame);
+        if (size != frame_len) {
+            std::string &list = size < frame_len ? raised : lowered;
+            if (list.size() < 40) {
+                list += (list.empty() ? "" : ", ") + std::to_string(size);
+            } else if (list.back() != '.') {
+                list += ", ...";
+            }
+        }
+        out->sizes.insert(out->sizes.end(), repeats * weight, frame_len);
+        sum += static_cast<double>(frame_len) * weight;
+    }
+    // Фиксированный seed: одна и та же последовательность в каждом запуске
+    std::mt19937 rng(0x4e424e43);
+    std::shuffle(out->sizes.begin(), out->sizes.end(), rng);
+
+    out->max_size = *std::max_element(out->sizes.begin(), out->sizes.end());
+    out->mean_size = sum / total_weight;
+    if (!raised.empty()) {
+        std::cerr << "Frame sizes " << raised << " are below the " << min_frame
+                  << "-byte minimum (headers + benchmark header) and are sent as " << min_frame << " bytes" << std::endl;
+    }
+    if (!lowered.empty()) {
+        std::cerr << "Frame sizes " << lowered << " are above the " << max_frame
+                  << "-byte maximum and are sent as " << max_frame << " bytes" << std::endl;
+    }
+    if (!opts.size_dist.empty()) {
+        std::cout << "Frame sizes: " << opts.size_dist << ", " << weights.size() << " sizes, mean "
+                  << out->mean_size << " bytes" << std::endl;
+    }
+    return true;
+}
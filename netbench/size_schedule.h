@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "options.h"
+
+// Расписание длин кадров, перемешивается один раз до запуска
+class SizeSchedule {
+public:
+    // Позиция потока в расписании
+    class Cursor {
+    public:
+        Cursor(const std::vector<uint16_t> &sizes, size_t start) : sizes(sizes.data()), len(sizes.size()), pos(start % len) {}
+
+        uint16_t next() {
+            uint16_t size = sizes[pos];
+            if (++pos == len) {
+                pos = 0;
+            }
+            return size;
+        }
+
+    private:
+        const uint16_t *sizes;
+        size_t len;
+        size_t pos;
+    };
+
+    SizeSchedule() : sizes(1, 0) {}
+
+    // Потоки начинают с разных позиций
+    Cursor cursor(unsigned worker_id, unsigned nb_workers) const {
+        return Cursor(sizes, sizes.size() * worker_id / std::max(nb_workers, 1u));
+    }
+
+    uint16_t max() const { return max_size; }
+    double mean() const { return mean_size; }
+
+    // Построение по opts.size_dist или opts.size, длины ограничены [min_frame, max_frame]
+    static bool build(const Options &opts, size_t size_offset, size_t min_frame, size_t max_frame, SizeSchedule *out);
+
+private:
+    std::vector<uint16_t> sizes;
+    uint16_t max_size = 0;
+    double mean_size = 0;
+};
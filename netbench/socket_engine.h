@@ -0,0 +1,94 @@
+#pragma once
+
+#include <linux/if_packet.h>
+#include <vector>
+
+#include "capture_writer.h"
+#include "device_counters.h"
+#include "engine.h"
+#include "frame.h"
+#include "latency_histogram.h"
+#include "options.h"
+#include "pcap_file.h"
+#include "poll_policy.h"
+#include "size_schedule.h"
+#include "token_bucket.h"
+
+// Отправка через AF_PACKET: сокет на поток, sendto(), PACKET_TX_RING, sendmmsg() или io_uring (--mode)
+class SocketTxEngine : public TxEngine {
+public:
+    explicit SocketTxEngine(const Options &opts) : opts(opts) {}
+
+    bool setup() override;
+    unsigned nb_workers() const override { return opts.threads; }
+    void transmit(unsigned worker_id, WorkerStats &stats) override;
+    void launch(const WorkerBody &body) override;
+    void report(std::ostream &os) const override;
+    void device_counters(DeviceCounters *counters) override { read_iface_counters(opts.iface, counters); }
+
+private:
+    enum class Mode { Sendto, TxRing, Mmsg, IoUring };
+
+    const Options &opts;
+    Mode mode = Mode::Sendto;
+    unsigned ifindex = 0;
+    uint8_t src_mac[6] = {};
+    SizeSchedule sizes;
+    FlowTable flows;
+    PcapFile pcap;
+    LatencyHistogram rtt_histogram;
+
+    TokenBucket pacer(unsigned burst, double *cost) const;
+    void send_sendto(WorkerStats &ws, int sockfd, const struct sockaddr_ll &addr, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow);
+    void send_tx_ring(WorkerStats &ws, int sockfd, const struct sockaddr_ll &addr, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow);
+    void send_mmsg(WorkerStats &ws, int sockfd, const struct sockaddr_ll &addr, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow);
+    void send_uring(WorkerStats &ws, int sockfd, const struct sockaddr_ll &addr, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow);
+    void send_replay(WorkerStats &ws, int sockfd, const struct sockaddr_ll &addr, unsigned worker_id);
+    void collect_reflected();
+};
+
+// Приём через AF_PACKET: сокет на поток в группе PACKET_FANOUT, recvfrom(), PACKET_RX_RING, recvmmsg() или io_uring (--mode)
+class SocketRxEngine : public RxEngine {
+public:
+    explicit SocketRxEngine(const Options &opts) : opts(opts) {}
+
+    bool setup() override;
+    unsigned nb_workers() const override { return opts.threads; }
+    void receive(unsigned worker_id, WorkerStats &stats, StreamTable &streams) override;
+    void report(std::ostream &os) const override { capture.report(os); }
+    void device_counters(DeviceCounters *counters) override;
+
+private:
+    enum class Mode { Recvfrom, RxRing, Mmsg, IoUring };
+
+    struct RxRing {
+        uint8_t *map = nullptr;
+        size_t size = 0;
+        unsigned block_size = 0;
+        unsigned block_nr = 0;
+    };
+
+    const Options &opts;
+    Mode mode = Mode::Recvfrom;
+    int fanout_mode = PACKET_FANOUT_HASH;
+    PollMode poll_mode = PollMode::Adaptive;
+    unsigned ifindex = 0;
+    uint32_t snaplen = 0;  // байт кадра после фильтра, 0 без фильтра
+    size_t buf_size = 0;   // буфер приёма на кадр
+    PacketSocketCounters socket_counters;  // PACKET_STATISTICS сокетов
+    CaptureSet capture;    // --record
+
+    // Длина кадра в сети по длине от ядра
+    size_t frame_len(const uint8_t *frame, size_t len) const {
+        return snaplen != 0 && len >= BENCH_UDP_OFFSET ? bench_frame_len(frame) : len;
+    }
+
+    int open_socket(RxRing *ring) const;
+    bool attach_filter(int sockfd) const;
+    bool setup_rx_ring(int sockfd, RxRing *ring) const;
+    void reflect_frame(int sockfd, uint8_t *frame, size_t len) const;
+    void receive_recvfrom(WorkerStats &ws, StreamTable &streams, int sockfd, CaptureWriter *recorder);
+    void receive_mmsg(WorkerStats &ws, StreamTable &streams, int sockfd, CaptureWriter *recorder);
+    void receive_rx_ring(WorkerStats &ws, StreamTable &streams, int sockfd, const RxRing &ring, CaptureWriter *recorder);
+    void receive_uring(WorkerStats &ws, StreamTable &streams, int sockfd, CaptureWriter *recorder);
+};
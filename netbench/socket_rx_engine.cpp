@@ -0,0 +1,468 @@
+#include "socket_engine.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <linux/filter.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "placement.h"
+#include "runner.h"
+#include "uring.h"
+
+#define BUF_SIZE 1024
+
+// Кольцо TPACKET_V3: ядро заполняет блоки целиком
+constexpr unsigned RX_RING_BLOCK_SIZE = 1 << 22;
+constexpr unsigned RX_RING_BLOCK_NR = 64;
+constexpr unsigned RX_RING_FRAME_SIZE = 2048;
+constexpr unsigned RX_RING_BLOCK_TIMEOUT_MS = 10;
+
+bool SocketRxEngine::setup() {
+    if (opts.mode.empty() || opts.mode == "recvfrom") {
+        mode = Mode::Recvfrom;
+    } else if (opts.mode == "rx-ring") {
+        mode = Mode::RxRing;
+    } else if (opts.mode == "mmsg") {
+        mode = Mode::Mmsg;
+    } else if (opts.mode == "io-uring") {
+        mode = Mode::IoUring;
+    } else {
+        std::cerr << "Unknown mode: " << opts.mode << " (expected recvfrom, rx-ring, mmsg or io-uring)" << std::endl;
+        return false;
+    }
+
+    if (opts.fanout == "hash") {
+        fanout_mode = PACKET_FANOUT_HASH;
+    } else if (opts.fanout == "cpu") {
+        fanout_mode = PACKET_FANOUT_CPU;
+    } else if (opts.fanout == "rollover") {
+        fanout_mode = PACKET_FANOUT_ROLLOVER;
+    } else {
+        std::cerr << "Unknown fanout mode: " << opts.fanout << " (expected hash, cpu or rollover)" << std::endl;
+        return false;
+    }
+
+    if (!parse_poll_mode(opts, &poll_mode)) {
+        std::cerr << "Unknown poll mode: " << opts.poll << " (expected busy, adaptive or interrupt)" << std::endl;
+        return false;
+    }
+
+    ifindex = if_nametoindex(opts.iface.c_str());
+    if (ifindex == 0) {
+        perror("if_nametoindex failed");
+        return false;
+    }
+
+    buf_size = BUF_SIZE + sizeof(struct ether_header);
+    if (!opts.record.empty()) {
+        // Для записи кадры сохраняются целиком (до --snaplen)
+        unsigned mtu = get_mtu(opts.iface.c_str());
+        buf_size = std::max<size_t>(buf_size, sizeof(struct ether_header) + 4 + (mtu ? mtu : ETH_DATA_LEN));
+    }
+
+    if (opts.filter) {
+        // Отражению нужен весь кадр, записи --snaplen байт, остальным заголовки
+        if (opts.reflect || (!opts.record.empty() && opts.record_snaplen == 0)) {
+            snaplen = UINT32_MAX;
+        } else if (!opts.record.empty()) {
+            snaplen = std::max<uint32_t>(opts.record_snaplen, BENCH_MIN_FRAME);
+        } else {
+            snaplen = BENCH_MIN_FRAME;
+        }
+        std::cout << "BPF filter: benchmark frames only";
+        if (snaplen != UINT32_MAX) {
+            std::cout << ", cut to " << snaplen << " bytes";
+        }
+        std::cout << std::endl;
+    }
+    return capture.open(opts, nb_workers());
+}
+
+// BPF-фильтр: только входящие кадры теста, snaplen байт
+bool SocketRxEngine::attach_filter(int sockfd) const {
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_PKTTYPE)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 9, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, offsetof(struct ether_header, ether_type)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETHERTYPE_IP, 0, 7),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, BENCH_IP_OFFSET + offsetof(struct iphdr, protocol)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 5),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, BENCH_HEADER_OFFSET + offsetof(BenchHeader, magic)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, BENCH_MAGIC, 0, 3),
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, BENCH_HEADER_OFFSET + offsetof(BenchHeader, flags)),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, BENCH_FLAG_REFLECTED, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, snaplen),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog prog = {sizeof(code) / sizeof(code[0]), code};
+    if (setsockopt(sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0) {
+        perror("setsockopt SO_ATTACH_FILTER failed");
+        return false;
+    }
+    return true;
+}
+
+// Поток приёма: свой сокет, статистика и таблица потоков
+void SocketRxEngine::receive(unsigned worker_id, WorkerStats &ws, StreamTable &streams) {
+    RxRing ring;
+    int sockfd = open_socket(&ring);
+    if (sockfd < 0) {
+        request_stop();
+        return;
+    }
+    socket_counters.add(sockfd);
+    CaptureWriter *recorder = capture.worker(worker_id);
+    if (recorder != nullptr && !recorder->start()) {
+        recorder = nullptr;
+        request_stop();
+    }
+
+    switch (mode) {
+    case Mode::RxRing:
+        receive_rx_ring(ws, streams, sockfd, ring, recorder);
+        munmap(ring.map, ring.size);
+        break;
+    case Mode::Mmsg:
+        receive_mmsg(ws, streams, sockfd, recorder);
+        break;
+    case Mode::IoUring:
+        receive_uring(ws, streams, sockfd, recorder);
+        break;
+    case Mode::Recvfrom:
+        receive_recvfrom(ws, streams, sockfd, recorder);
+        break;
+    }
+
+    if (recorder != nullptr) {
+        recorder->finish();
+    }
+    socket_counters.remove(sockfd);
+    close(sockfd);
+}
+
+void SocketRxEngine::device_counters(DeviceCounters *counters) {
+    read_iface_counters(opts.iface, counters);
+    socket_counters.read(counters);
+    capture.counters(counters);
+}
+
+// Ожидание для --poll interrupt, не дольше 100 мс
+static void wait_readable(int sockfd) {
+    struct pollfd pfd = {sockfd, POLLIN, 0};
+    poll(&pfd, 1, 100);
+}
+
+// Отражение кадра отправителю для замера RTT
+void SocketRxEngine::reflect_frame(int sockfd, uint8_t *frame, size_t len) const {
+    bench_reflect(frame);
+    if (send(sockfd, frame, len, 0) < 0) {
+        perror("reflect send failed");
+    }
+}
+
+void SocketRxEngine::receive_recvfrom(WorkerStats &ws, StreamTable &streams, int sockfd, CaptureWriter *recorder) {
+    FrameBuffer frame_buffer(buf_size);
+    if (frame_buffer.data() == nullptr) {
+        return;
+    }
+    uint8_t *buffer = frame_buffer.data();
+
+    PollPolicy policy(poll_mode, opts.poll_sleep_us, ws);
+    auto wait = [sockfd] { wait_readable(sockfd); };
+
+    // Сбор статистики
+    while (!stop_requested()) {
+        // MSG_TRUNC возвращает полную длину кадра
+        ssize_t n = recvfrom(sockfd, buffer, frame_buffer.size(), MSG_TRUNC | MSG_DONTWAIT, NULL, NULL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                policy.after_poll(0, wait);
+                continue;
+            }
+            perror("recvfrom failed");
+            break;
+        }
+
+        size_t len = frame_len(buffer, n);
+        ws.add(1, len);
+        if (recorder != nullptr) {
+            recorder->add(buffer, std::min<size_t>(n, frame_buffer.size()), len, recorder->now_ns());
+        }
+        if (streams.record(buffer, std::min<size_t>(n, frame_buffer.size()))) {
+            ws.add_good(1, len);
+            ws.add_size(len);
+            if (opts.reflect) {
+                reflect_frame(sockfd, buffer, std::min<size_t>(n, frame_buffer.size()));
+            }
+        }
+        policy.after_poll(1, wait);
+    }
+    policy.finish();
+}
+
+// recvmmsg(): до opts.batch кадров за вызов
+void SocketRxEngine::receive_mmsg(WorkerStats &ws, StreamTable &streams, int sockfd, CaptureWriter *recorder) {
+    const unsigned batch_size = opts.batch;
+    FrameBuffer buffers(static_cast<size_t>(batch_size) * buf_size);
+    if (buffers.data() == nullptr) {
+        return;
+    }
+    std::vector<struct iovec> iovs(batch_size);
+    std::vector<struct mmsghdr> msgs(batch_size);
+    for (unsigned i = 0; i < batch_size; i++) {
+        iovs[i].iov_base = buffers.data() + static_cast<size_t>(i) * buf_size;
+        iovs[i].iov_len = buf_size;
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    PollPolicy policy(poll_mode, opts.poll_sleep_us, ws);
+    auto wait = [sockfd] { wait_readable(sockfd); };
+    while (!stop_requested()) {
+        int n = recvmmsg(sockfd, msgs.data(), msgs.size(), MSG_DONTWAIT | MSG_TRUNC, NULL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                policy.after_poll(0, wait);
+                continue;
+            }
+            perror("recvmmsg failed");
+            break;
+        }
+
+        uint64_t bytes = 0;
+        uint64_t good = 0, good_bytes = 0;
+        uint64_t now_ns = recorder != nullptr ? recorder->now_ns() : 0;
+        for (int i = 0; i < n; i++) {
+            size_t len = frame_len(static_cast<uint8_t *>(iovs[i].iov_base), msgs[i].msg_len);
+            bytes += len;
+            if (recorder != nullptr) {
+                recorder->add(static_cast<uint8_t *>(iovs[i].iov_base), std::min<size_t>(msgs[i].msg_len, iovs[i].iov_len), len, now_ns);
+            }
+            if (streams.record(static_cast<uint8_t *>(iovs[i].iov_base), std::min<size_t>(msgs[i].msg_len, iovs[i].iov_len))) {
+                good++;
+                good_bytes += len;
+                ws.add_size(len);
+                if (opts.reflect) {
+                    reflect_frame(sockfd, static_cast<uint8_t *>(iovs[i].iov_base), std::min<size_t>(msgs[i].msg_len, iovs[i].iov_len));
+                }
+            }
+        }
+        ws.add(n, bytes);
+        ws.add_good(good, good_bytes);
+        policy.after_poll(n, wait);
+    }
+    policy.finish();
+}
+
+// io_uring: opts.qd чтений в работе, слот сразу отправляется снова
+void SocketRxEngine::receive_uring(WorkerStats &ws, StreamTable &streams, int sockfd, CaptureWriter *recorder) {
+    // read() обрезает кадр, поэтому слот вмещает весь MTU
+    const size_t slot_size = std::max<size_t>(2048, (buf_size + 63) & ~size_t{63});
+    const unsigned depth = opts.qd;
+    FrameBuffer slots(static_cast<size_t>(depth) * slot_size);
+    if (slots.data() == nullptr) {
+        return;
+    }
+
+    Uring ring;
+    if (!uring_init(&ring, depth, opts.sqpoll) || !uring_register(&ring, sockfd, slots.data(), slots.size())) {
+        uring_close(&ring);
+        return;
+    }
+
+    auto post = [&](unsigned slot) {
+        struct io_uring_sqe *sqe = ring.get_sqe();
+        uring_prep_fixed(sqe, IORING_OP_READ_FIXED, slots.data() + slot * slot_size, slot_size, slot);
+    };
+    for (unsigned i = 0; i < depth; i++) {
+        post(i);
+    }
+    ring.submit(false);
+
+    PollPolicy policy(poll_mode, opts.poll_sleep_us, ws);
+    auto wait = [&ring] { ring.wait_cqe(100); };
+    while (!stop_requested()) {
+        uint64_t packets = 0, bytes = 0;
+        uint64_t good = 0, good_bytes = 0;
+        uint64_t now_ns = recorder != nullptr ? recorder->now_ns() : 0;
+        unsigned n = ring.for_each_cqe([&](const struct io_uring_cqe &cqe) {
+            if (cqe.res > 0) {
+                uint8_t *frame = slots.data() + cqe.user_data * slot_size;
+                size_t len = frame_len(frame, cqe.res);
+                packets++;
+                bytes += len;
+                if (recorder != nullptr) {
+                    recorder->add(frame, cqe.res, len, now_ns);
+                }
+                if (streams.record(frame, cqe.res)) {
+                    good++;
+                    good_bytes += len;
+                    ws.add_size(len);
+                    if (opts.reflect) {
+                        reflect_frame(sockfd, frame, cqe.res);
+                    }
+                }
+            } else if (cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR) {
+                std::cerr << "io_uring read failed: " << strerror(-cqe.res) << std::endl;
+                request_stop();
+            }
+            // CQ разбирается до submit, поэтому в SQ всегда есть место
+            post(cqe.user_data);
+        });
+        ws.add(packets, bytes);
+        ws.add_good(good, good_bytes);
+
+        if (n > 0) {
+            ring.submit(false);
+        }
+        policy.after_poll(n, wait);
+    }
+    policy.finish();
+
+    // Закрытие кольца отменяет чтения, после него слоты можно освободить
+    uring_close(&ring);
+}
+
+// PACKET_RX_RING (TPACKET_V3) до привязки сокета и fanout
+bool SocketRxEngine::setup_rx_ring(int sockfd, RxRing *ring) const {
+    int version = TPACKET_V3;
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        perror("setsockopt PACKET_VERSION failed");
+        return false;
+    }
+
+    struct tpacket_req3 req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = RX_RING_BLOCK_SIZE;
+    req.tp_block_nr = RX_RING_BLOCK_NR;
+    req.tp_frame_size = RX_RING_FRAME_SIZE;
+    req.tp_frame_nr = (RX_RING_BLOCK_SIZE / RX_RING_FRAME_SIZE) * RX_RING_BLOCK_NR;
+    req.tp_retire_blk_tov = RX_RING_BLOCK_TIMEOUT_MS;
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        perror("setsockopt PACKET_RX_RING failed");
+        return false;
+    }
+
+    ring->size = static_cast<size_t>(req.tp_block_size) * req.tp_block_nr;
+    ring->block_size = req.tp_block_size;
+    ring->block_nr = req.tp_block_nr;
+    ring->map = static_cast<uint8_t *>(mmap(nullptr, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, sockfd, 0));
+    if (ring->map == MAP_FAILED) {
+        perror("mmap RX ring failed");
+        ring->map = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Кадры читаются прямо из готовых блоков
+void SocketRxEngine::receive_rx_ring(WorkerStats &ws, StreamTable &streams, int sockfd, const RxRing &ring, CaptureWriter *recorder) {
+    unsigned block = 0;
+    PollPolicy policy(poll_mode, opts.poll_sleep_us, ws);
+    auto wait = [sockfd] { wait_readable(sockfd); };
+    while (!stop_requested()) {
+        auto *desc = reinterpret_cast<struct tpacket_block_desc *>(ring.map + static_cast<size_t>(block) * ring.block_size);
+        if (!(__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER)) {
+            policy.after_poll(0, wait);
+            continue;
+        }
+
+        uint32_t num_pkts = desc->hdr.bh1.num_pkts;
+        auto *pkt = reinterpret_cast<struct tpacket3_hdr *>(reinterpret_cast<uint8_t *>(desc) + desc->hdr.bh1.offset_to_first_pkt);
+        uint64_t bytes = 0;
+        uint64_t good = 0, good_bytes = 0;
+        for (uint32_t i = 0; i < num_pkts; i++) {
+            bytes += pkt->tp_len;
+            if (recorder != nullptr) {
+                // Время приёма по ядру
+                recorder->add(reinterpret_cast<uint8_t *>(pkt) + pkt->tp_mac, pkt->tp_snaplen, pkt->tp_len,
+                              pkt->tp_sec * 1000000000ULL + pkt->tp_nsec);
+            }
+            if (streams.record(reinterpret_cast<uint8_t *>(pkt) + pkt->tp_mac, pkt->tp_snaplen)) {
+                good++;
+                good_bytes += pkt->tp_len;
+                ws.add_size(pkt->tp_len);
+                if (opts.reflect) {
+                    // Блок наш до возврата, кадр разворачивается на месте
+                    reflect_frame(sockfd, reinterpret_cast<uint8_t *>(pkt) + pkt->tp_mac, pkt->tp_snaplen);
+                }
+            }
+            pkt = reinterpret_cast<struct tpacket3_hdr *>(reinterpret_cast<uint8_t *>(pkt) + pkt->tp_next_offset);
+        }
+
+        ws.add(num_pkts, bytes);
+        ws.add_good(good, good_bytes);
+
+        // Возврат блока ядру
+        __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        block = (block + 1) % ring.block_nr;
+        policy.after_poll(num_pkts, wait);
+    }
+    policy.finish();
+}
+
+// Сокет AF_PACKET на интерфейсе, в группе PACKET_FANOUT; -1 при ошибке
+int SocketRxEngine::open_socket(RxRing *ring) const {
+    int sockfd;
+    struct sockaddr_ll socket_address;
+
+    // Создание сокета
+    if ((sockfd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL))) < 0) {
+        perror("socket creation failed");
+        return -1;
+    }
+
+    // Фильтр ставится до привязки
+    if (snaplen != 0 && !attach_filter(sockfd)) {
+        close(sockfd);
+        return -1;
+    }
+
+    // Ядро опрашивает очередь перед сном
+    if (opts.busy_poll_us > 0) {
+        int busy_poll = opts.busy_poll_us;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) < 0) {
+            perror("setsockopt SO_BUSY_POLL failed");
+        }
+    }
+
+    if (mode == Mode::RxRing && !setup_rx_ring(sockfd, ring)) {
+        close(sockfd);
+        return -1;
+    }
+
+    memset(&socket_address, 0, sizeof(socket_address));
+
+    // Установка интерфейса
+    socket_address.sll_family = AF_PACKET;
+    socket_address.sll_ifindex = ifindex;
+    socket_address.sll_protocol = htons(ETH_P_ALL);
+
+    // Привязка сокета к интерфейсу
+    if (bind(sockfd, (struct sockaddr*)&socket_address, sizeof(socket_address)) < 0) {
+        perror("bind failed");
+        close(sockfd);
+        return -1;
+    }
+
+    if (nb_workers() > 1) {
+        int fanout_arg = (getpid() & 0xffff) | (fanout_mode << 16);
+        if (setsockopt(sockfd, SOL_PACKET, PACKET_FANOUT, &fanout_arg, sizeof(fanout_arg)) < 0) {
+            perror("setsockopt PACKET_FANOUT failed");
+            close(sockfd);
+            return -1;
+        }
+    }
+
+    return sockfd;
+}
@@ -0,0 +1,532 @@
+#include "socket_engine.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "frame.h"
+#include "placement.h"
+#include "runner.h"
+#include "uring.h"
+
+// Кадров в TX ring на один вызов sendto()
+constexpr unsigned TX_RING_BATCH = 64;
+constexpr unsigned TX_RING_FRAMES = 4096;
+
+bool SocketTxEngine::setup() {
+    if (opts.mode.empty() || opts.mode == "sendto") {
+        mode = Mode::Sendto;
+    } else if (opts.mode == "tx-ring") {
+        mode = Mode::TxRing;
+    } else if (opts.mode == "mmsg") {
+        mode = Mode::Mmsg;
+    } else if (opts.mode == "io-uring") {
+        mode = Mode::IoUring;
+    } else {
+        std::cerr << "Unknown mode: " << opts.mode << " (expected sendto, tx-ring, mmsg or io-uring)" << std::endl;
+        return false;
+    }
+
+    ifindex = if_nametoindex(opts.iface.c_str());
+    if (ifindex == 0) {
+        perror("if_nametoindex failed");
+        return false;
+    }
+    if (!opts.replay.empty()) {
+        // Кольцу и буферу io_uring нужна копия каждого кадра
+        if (mode != Mode::Sendto && mode != Mode::Mmsg) {
+            std::cerr << "--replay sends with --mode sendto or mmsg" << std::endl;
+            return false;
+        }
+        unsigned mtu = get_mtu(opts.iface.c_str());
+        return pcap.open(opts.replay, sizeof(struct ether_header) + (mtu ? mtu : ETH_DATA_LEN));
+    }
+
+    // MAC-адрес источника
+    get_mac_address(opts.iface.c_str(), src_mac);
+    flows = FlowTable(src_mac, opts.dst_mac.data(), opts.flows);
+    // Каждый кадр вмещает заголовок теста
+    return SizeSchedule::build(opts, sizeof(struct ether_header), BENCH_MIN_FRAME, UINT16_MAX, &sizes);
+}
+
+TokenBucket SocketTxEngine::pacer(unsigned burst, double *cost) const {
+    return make_pacer(opts.rate_pps, opts.rate_bps, nb_workers(), sizes.mean(), burst, tsc_hz(), cost);
+}
+
+void SocketTxEngine::transmit(unsigned worker_id, WorkerStats &ws) {
+    int sockfd;
+
+    // Создание сокета; для io_uring с протоколом 0, чтобы ничего не принимать
+    int protocol = mode == Mode::IoUring ? 0 : htons(ETH_P_ALL);
+    if ((sockfd = socket(AF_PACKET, SOCK_RAW, protocol)) < 0) {
+        perror("socket creation failed");
+        return;
+    }
+
+    struct sockaddr_ll socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+
+    // Установка интерфейса
+    socket_address.sll_ifindex = ifindex;
+    socket_address.sll_halen = ETH_ALEN;
+    memcpy(socket_address.sll_addr, opts.dst_mac.data(), 6);
+
+    if (!opts.replay.empty()) {
+        send_replay(ws, sockfd, socket_address, worker_id);
+        close(sockfd);
+        std::cout << "Thread " << worker_id << " stopped." << std::endl;
+        return;
+    }
+
+    // Кадр наибольшего размера, короткие - его начало
+    std::vector<uint8_t> frame = build_bench_frame(flows, sizes.max(), worker_id);
+    SizeSchedule::Cursor frame_sizes = sizes.cursor(worker_id, nb_workers());
+    unsigned flow = worker_id % flows.size();
+
+    switch (mode) {
+    case Mode::Sendto:
+        send_sendto(ws, sockfd, socket_address, frame, frame_sizes, flow);
+        break;
+    case Mode::TxRing:
+        send_tx_ring(ws, sockfd, socket_address, frame, frame_sizes, flow);
+        break;
+    case Mode::Mmsg:
+        send_mmsg(ws, sockfd, socket_address, frame, frame_sizes, flow);
+        break;
+    case Mode::IoUring:
+        send_uring(ws, sockfd, socket_address, frame, frame_sizes, flow);
+        break;
+    }
+
+    close(sockfd);
+    std::cout << "Thread " << worker_id << " stopped." << std::endl;
+}
+
+void SocketTxEngine::send_sendto(WorkerStats &ws, int sockfd, const struct sockaddr_ll &socket_address, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow) {
+    FrameBuffer buffer(frame.size());
+    if (buffer.data() == nullptr) {
+        return;
+    }
+    memcpy(buffer.data(), frame.data(), frame.size());
+
+    // Отправка сообщений
+    uint64_t seq = 0;
+    double cost;
+    TokenBucket bucket = pacer(1, &cost);
+    while (!stop_requested()) {
+        if (bucket.enabled()) {
+            if (bucket.wait([] { return __rdtsc(); }, cost, 1, stop_requested) == 0) {
+                continue;
+            }
+        }
+        uint16_t len = frame_sizes.next();
+        bucket.consume_sent(1, len);
+        bench_header_set_seq(buffer.data(), seq++);
+        if (opts.latency) {
+            bench_header_set_timestamp(buffer.data(), monotonic_raw_ns());
+        }
+        flows.write_headers(buffer.data(), flow, len);
+        flow = flows.next(flow);
+        if (sendto(sockfd, buffer.data(), len, 0, reinterpret_cast<const struct sockaddr*>(&socket_address), sizeof(socket_address)) < 0) {
+            perror("sendto failed");
+            break;
+        }
+        ws.add(1, len);
+        if (opts.use_sleep) {
+            usleep(1000);  // Пауза для демонстрации
+        }
+    }
+}
+
+// PACKET_TX_RING (TPACKET_V2): слоты заполняются один раз, ядро будится одним send() на TX_RING_BATCH кадров
+void SocketTxEngine::send_tx_ring(WorkerStats &ws, int sockfd, const struct sockaddr_ll &socket_address, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow) {
+    int version = TPACKET_V2;
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        perror("setsockopt PACKET_VERSION failed");
+        return;
+    }
+
+    // Слот: tpacket2_hdr, затем кадр Ethernet
+    unsigned frame_size = 2048;
+    while (frame_size < TPACKET2_HDRLEN + frame.size()) {
+        frame_size <<= 1;
+    }
+    struct tpacket_req req;
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = std::max(frame_size, 1u << 16);
+    req.tp_frame_size = frame_size;
+    req.tp_block_nr = std::max(1u, TX_RING_FRAMES * frame_size / req.tp_block_size);
+    req.tp_frame_nr = req.tp_block_nr * (req.tp_block_size / frame_size);
+    if (setsockopt(sockfd, SOL_PACKET, PACKET_TX_RING, &req, sizeof(req)) < 0) {
+        perror("setsockopt PACKET_TX_RING failed");
+        return;
+    }
+
+    size_t ring_size = static_cast<size_t>(req.tp_block_size) * req.tp_block_nr;
+    void *ring = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, sockfd, 0);
+    if (ring == MAP_FAILED) {
+        perror("mmap TX ring failed");
+        return;
+    }
+
+    auto slot = [&](unsigned idx) {
+        return reinterpret_cast<struct tpacket2_hdr *>(static_cast<uint8_t *>(ring) + static_cast<size_t>(idx) * frame_size);
+    };
+    // Без PACKET_TX_HAS_OFF данные сразу после заголовка
+    constexpr size_t data_offset = TPACKET2_HDRLEN - sizeof(struct sockaddr_ll);
+    for (unsigned i = 0; i < req.tp_frame_nr; i++) {
+        memcpy(reinterpret_cast<uint8_t *>(slot(i)) + data_offset, frame.data(), frame.size());
+    }
+
+    unsigned idx = 0;
+    uint64_t seq = 0;
+    double cost;
+    TokenBucket bucket = pacer(TX_RING_BATCH, &cost);
+    while (!stop_requested()) {
+        unsigned limit = TX_RING_BATCH;
+        if (bucket.enabled()) {
+            limit = bucket.wait([] { return __rdtsc(); }, cost, TX_RING_BATCH, stop_requested);
+        }
+        unsigned queued = 0;
+        uint64_t queued_bytes = 0;
+        while (queued < limit) {
+            struct tpacket2_hdr *hdr = slot(idx);
+            uint32_t status = __atomic_load_n(&hdr->tp_status, __ATOMIC_ACQUIRE);
+            if (status == TP_STATUS_WRONG_FORMAT) {
+                std::cerr << "TX ring: kernel rejected frame format" << std::endl;
+                request_stop();
+                break;
+            }
+            if (status != TP_STATUS_AVAILABLE) {
+                break;
+            }
+            uint8_t *data = reinterpret_cast<uint8_t *>(hdr) + data_offset;
+            hdr->tp_len = frame_sizes.next();
+            queued_bytes += hdr->tp_len;
+            bench_header_set_seq(data, seq++);
+            if (opts.latency) {
+                bench_header_set_timestamp(data, monotonic_raw_ns());
+            }
+            flows.write_headers(data, flow, hdr->tp_len);
+            flow = flows.next(flow);
+            __atomic_store_n(&hdr->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+            idx = (idx + 1) % req.tp_frame_nr;
+            queued++;
+        }
+
+        if (queued == 0) {
+            // Кольцо заполнено: ждём освобождения слота
+            struct pollfd pfd = {sockfd, POLLOUT, 0};
+            poll(&pfd, 1, 100);
+            continue;
+        }
+
+        if (sendto(sockfd, nullptr, 0, MSG_DONTWAIT, reinterpret_cast<const struct sockaddr*>(&socket_address), sizeof(socket_address)) < 0 && errno != EAGAIN) {
+            perror("sendto TX ring kick failed");
+            break;
+        }
+        bucket.consume_sent(queued, queued_bytes);
+        ws.add(queued, queued_bytes);
+
+        if (opts.use_sleep) {
+            usleep(1000);  // Пауза для демонстрации
+        }
+    }
+
+    munmap(ring, ring_size);
+}
+
+// sendmmsg(): копия кадра на сообщение, меняются только номера
+void SocketTxEngine::send_mmsg(WorkerStats &ws, int sockfd, const struct sockaddr_ll &socket_address, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow) {
+    const unsigned batch_size = opts.batch;
+    FrameBuffer frames(static_cast<size_t>(batch_size) * frame.size());
+    if (frames.data() == nullptr) {
+        return;
+    }
+    std::vector<struct iovec> iovs(batch_size);
+    std::vector<struct mmsghdr> msgs(batch_size);
+    for (unsigned i = 0; i < batch_size; i++) {
+        iovs[i].iov_base = frames.data() + static_cast<size_t>(i) * frame.size();
+        iovs[i].iov_len = frame.size();
+        memcpy(iovs[i].iov_base, frame.data(), frame.size());
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_name = const_cast<struct sockaddr_ll *>(&socket_address);
+        msgs[i].msg_hdr.msg_namelen = sizeof(socket_address);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t seq = 0;
+    unsigned prepared = 0;  // неотправленные кадры прошлого вызова, в начале массива
+    double cost;
+    TokenBucket bucket = pacer(batch_size, &cost);
+    while (!stop_requested()) {
+        unsigned count = batch_size;
+        if (bucket.enabled()) {
+            count = bucket.wait([] { return __rdtsc(); }, cost, batch_size, stop_requested);
+            if (count == 0) {
+                continue;
+            }
+        }
+        for (unsigned i = prepared; i < count; i++) {
+            auto *data = static_cast<uint8_t *>(iovs[i].iov_base);
+            iovs[i].iov_len = frame_sizes.next();
+            bench_header_set_seq(data, seq++);
+            flows.write_headers(data, flow, iovs[i].iov_len);
+            flow = flows.next(flow);
+        }
+        prepared = std::max(prepared, count);
+        if (opts.latency) {
+            for (unsigned i = 0; i < count; i++) {
+                bench_header_set_timestamp(static_cast<uint8_t *>(iovs[i].iov_base), monotonic_raw_ns());
+            }
+        }
+        int sent = sendmmsg(sockfd, msgs.data(), count, 0);
+        if (sent < 0) {
+            if (errno != ENOBUFS && errno != EAGAIN) {
+                perror("sendmmsg failed");
+                break;
+            }
+            // Очередь устройства заполнена: кадры отправляются повторно
+            ws.add_drops(count);
+            usleep(10);
+            continue;
+        }
+        uint64_t sent_bytes = 0;
+        for (int i = 0; i < sent; i++) {
+            sent_bytes += iovs[i].iov_len;
+        }
+        // Неотправленные кадры переносятся в начало с теми же номерами
+        for (unsigned i = sent; i < prepared; i++) {
+            std::swap(iovs[i - sent], iovs[i]);
+        }
+        prepared -= sent;
+        bucket.consume_sent(sent, sent_bytes);
+        ws.add(sent, sent_bytes);
+
+        if (opts.use_sleep) {
+            usleep(1000);  // Пауза для демонстрации
+        }
+    }
+}
+
+// --replay: кадры прямо из отображённого файла через sendto() или sendmmsg()
+void SocketTxEngine::send_replay(WorkerStats &ws, int sockfd, const struct sockaddr_ll &socket_address, unsigned worker_id) {
+    const unsigned batch_size = mode == Mode::Mmsg ? opts.batch : 1;
+    std::vector<const PcapRecord *> frames(batch_size);
+    std::vector<struct iovec> iovs(batch_size);
+    std::vector<struct mmsghdr> msgs(batch_size);
+    for (unsigned i = 0; i < batch_size; i++) {
+        memset(&msgs[i], 0, sizeof(msgs[i]));
+        msgs[i].msg_hdr.msg_name = const_cast<struct sockaddr_ll *>(&socket_address);
+        msgs[i].msg_hdr.msg_namelen = sizeof(socket_address);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    ReplayCursor cursor(pcap, worker_id, nb_workers(), opts.replay_speed, opts.replay_loops, tsc_hz());
+    double cost;
+    TokenBucket bucket = make_pacer(opts.rate_pps, opts.rate_bps, nb_workers(), pcap.mean_len(), batch_size, tsc_hz(), &cost);
+    while (!stop_requested()) {
+        unsigned count = batch_size;
+        if (bucket.enabled()) {
+            count = bucket.wait([] { return __rdtsc(); }, cost, batch_size, stop_requested);
+            if (count == 0) {
+                continue;
+            }
+        }
+        count = cursor.next(frames.data(), count);
+        if (count == 0) {
+            break;  // все проходы отправлены
+        }
+        for (unsigned i = 0; i < count; i++) {
+            iovs[i].iov_base = const_cast<uint8_t *>(pcap.data(*frames[i]));
+            iovs[i].iov_len = frames[i]->len;
+        }
+
+        int sent;
+        if (mode == Mode::Mmsg) {
+            sent = sendmmsg(sockfd, msgs.data(), count, 0);
+        } else {
+            sent = sendto(sockfd, iovs[0].iov_base, iovs[0].iov_len, 0,
+                          reinterpret_cast<const struct sockaddr*>(&socket_address), sizeof(socket_address)) < 0 ? -1 : 1;
+        }
+        if (sent < 0) {
+            if (errno != ENOBUFS && errno != EAGAIN) {
+                perror(mode == Mode::Mmsg ? "sendmmsg failed" : "sendto failed");
+                break;
+            }
+            sent = 0;
+        }
+        cursor.unget(count - sent);
+
+        uint64_t sent_bytes = 0;
+        for (int i = 0; i < sent; i++) {
+            sent_bytes += iovs[i].iov_len;
+        }
+        bucket.consume_sent(sent, sent_bytes);
+        ws.add(sent, sent_bytes);
+    }
+}
+
+// io_uring: opts.qd записей в работе, завершённый слот сразу отправляется снова
+void SocketTxEngine::send_uring(WorkerStats &ws, int sockfd, const struct sockaddr_ll &socket_address, const std::vector<uint8_t> &frame, SizeSchedule::Cursor &frame_sizes, unsigned flow) {
+    // У write() нет адреса, поэтому сокет привязывается к интерфейсу
+    struct sockaddr_ll bind_address = socket_address;
+    bind_address.sll_family = AF_PACKET;
+    bind_address.sll_protocol = 0;
+    if (bind(sockfd, reinterpret_cast<struct sockaddr*>(&bind_address), sizeof(bind_address)) < 0) {
+        perror("bind failed");
+        return;
+    }
+
+    const unsigned depth = opts.qd;
+    FrameBuffer slots(static_cast<size_t>(depth) * frame.size());
+    if (slots.data() == nullptr) {
+        return;
+    }
+    std::vector<unsigned> free_slots;
+    for (unsigned i = 0; i < depth; i++) {
+        memcpy(slots.data() + static_cast<size_t>(i) * frame.size(), frame.data(), frame.size());
+        free_slots.push_back(i);
+    }
+
+    Uring ring;
+    if (!uring_init(&ring, depth, opts.sqpoll) || !uring_register(&ring, sockfd, slots.data(), slots.size())) {
+        uring_close(&ring);
+        return;
+    }
+
+    uint64_t seq = 0;
+    unsigned in_flight = 0;
+    double cost;
+    TokenBucket bucket = pacer(depth, &cost);
+    while (!stop_requested()) {
+        unsigned count = free_slots.size();
+        if (bucket.enabled() && count > 0) {
+            count = bucket.wait([] { return __rdtsc(); }, cost, count, stop_requested);
+        }
+        unsigned queued = 0;
+        uint64_t queued_bytes = 0;
+        struct io_uring_sqe *sqe;
+        while (queued < count && (sqe = ring.get_sqe()) != nullptr) {
+            unsigned slot = free_slots.back();
+            free_slots.pop_back();
+            uint8_t *data = slots.data() + static_cast<size_t>(slot) * frame.size();
+            uint16_t len = frame_sizes.next();
+            bench_header_set_seq(data, seq++);
+            if (opts.latency) {
+                bench_header_set_timestamp(data, monotonic_raw_ns());
+            }
+            flows.write_headers(data, flow, len);
+            flow = flows.next(flow);
+            uring_prep_fixed(sqe, IORING_OP_WRITE_FIXED, data, len, slot);
+            queued++;
+            queued_bytes += len;
+        }
+        bucket.consume_sent(queued, queued_bytes);
+        in_flight += queued;
+
+        // Без SQPOLL submit ждёт, когда все слоты в работе
+        if (ring.submit(free_slots.empty() && !opts.sqpoll) < 0 && errno != EINTR && errno != EBUSY) {
+            perror("io_uring_enter failed");
+            break;
+        }
+
+        uint64_t sent = 0, sent_bytes = 0;
+        in_flight -= ring.for_each_cqe([&](const struct io_uring_cqe &cqe) {
+            free_slots.push_back(cqe.user_data);
+            if (cqe.res >= 0) {
+                sent++;
+                sent_bytes += cqe.res;
+            } else if (cqe.res == -ENOBUFS || cqe.res == -EAGAIN) {
+                ws.add_drops(1);
+            } else {
+                std::cerr << "io_uring write failed: " << strerror(-cqe.res) << std::endl;
+                request_stop();
+            }
+        });
+        ws.add(sent, sent_bytes);
+
+        if (opts.use_sleep) {
+            usleep(1000);  // Пауза для демонстрации
+        }
+    }
+
+    // Ядро читает слоты до завершения последней записи
+    while (in_flight > 0 && ring.wait_cqe(100) >= 0) {
+        in_flight -= ring.for_each_cqe([](const struct io_uring_cqe &) {});
+    }
+    uring_close(&ring);
+}
+
+// Приём отражённых кадров и замер RTT
+void SocketTxEngine::collect_reflected() {
+    int sockfd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (sockfd < 0) {
+        perror("latency socket creation failed");
+        return;
+    }
+
+    // Иначе здесь были бы и свои исходящие кадры
+    int one = 1;
+    setsockopt(sockfd, SOL_PACKET, PACKET_IGNORE_OUTGOING, &one, sizeof(one));
+    struct timeval timeout = {0, 100000};
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    struct sockaddr_ll socket_address;
+    memset(&socket_address, 0, sizeof(socket_address));
+    socket_address.sll_family = AF_PACKET;
+    socket_address.sll_protocol = htons(ETH_P_ALL);
+    socket_address.sll_ifindex = ifindex;
+    if (bind(sockfd, reinterpret_cast<struct sockaddr*>(&socket_address), sizeof(socket_address)) < 0) {
+        perror("latency socket bind failed");
+        close(sockfd);
+        return;
+    }
+
+    uint8_t buffer[ETH_FRAME_LEN];
+    while (!stop_requested()) {
+        ssize_t n = recv(sockfd, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            continue;  // таймаут, проверка флага остановки
+        }
+        uint16_t stream_id, flags;
+        uint64_t seq;
+        if (bench_header_parse(buffer, n, &stream_id, &seq, &flags) && (flags & BENCH_FLAG_REFLECTED)) {
+            rtt_histogram.record(monotonic_raw_ns() - bench_header_timestamp(buffer));
+        }
+    }
+
+    close(sockfd);
+}
+
+void SocketTxEngine::launch(const WorkerBody &body) {
+    std::thread latency;
+    if (opts.latency) {
+        latency = std::thread([this] {
+            pin_helper();
+            collect_reflected();
+        });
+    }
+    launch_threads(nb_workers(), body);
+    request_stop();
+    if (latency.joinable()) {
+        latency.join();
+    }
+}
+
+void SocketTxEngine::report(std::ostream &os) const {
+    if (opts.latency) {
+        print_latency_report(os, rtt_histogram);
+    }
+}
@@ -0,0 +1,51 @@
+#include "stats.h"
+
+#include <array>
+#include <iomanip>
+#include <sstream>
+
+const char *const SIZE_BUCKET_NAMES[SIZE_BUCKETS] = {"64", "65-127", "128-255", "256-511", "512-1023", "1024-1518", "1519+"};
+const char *const POLL_STATE_NAMES[POLL_STATES] = {"busy", "spin", "pause", "sleep", "wait"};
+
+StatsSnapshot Stats::snapshot() const {
+    StatsSnapshot snap;
+    snap.time = std::chrono::steady_clock::now();
+    for (const auto &worker : workers) {
+        snap.packets += worker.packets.load(std::memory_order_relaxed);
+        snap.bytes += worker.bytes.load(std::memory_order_relaxed);
+        snap.good_packets += worker.good_packets.load(std::memory_order_relaxed);
+        snap.good_bytes += worker.good_bytes.load(std::memory_order_relaxed);
+        snap.drops += worker.drops.load(std::memory_order_relaxed);
+    }
+    return snap;
+}
+
+StatsSnapshot Stats::snapshot(size_t worker) const {
+    const WorkerStats &ws = workers[worker];
+    StatsSnapshot snap;
+    snap.time = std::chrono::steady_clock::now();
+    snap.packets = ws.packets.load(std::memory_order_relaxed);
+    snap.bytes = ws.bytes.load(std::memory_order_relaxed);
+    snap.good_packets = ws.good_packets.load(std::memory_order_relaxed);
+    snap.good_bytes = ws.good_bytes.load(std::memory_order_relaxed);
+    snap.drops = ws.drops.load(std::memory_order_relaxed);
+    return snap;
+}
+
+void Stats::start(size_t nb_workers) {
+    workers = std::vector<WorkerStats>(nb_workers);
+    last = snapshot();
+    start_time = last.time;
+}
+
+std::string format_unit(double value) {
+    const std::array<std::string, 5> units = {"", "K", "M", "G", "T"};
+    int i = 0;
+    while (value >= 1000.0 && i < 4) {
+        value /= 1000.0;
+        i++;
+    }
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2) << value << " " << units[i];
+    return oss.str();
+}
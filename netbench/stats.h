@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Диапазоны размеров кадров RMON: 64, 65-127, 128-255, 256-511, 512-1023, 1024-1518, 1519+
+constexpr size_t SIZE_BUCKETS = 7;
+extern const char *const SIZE_BUCKET_NAMES[SIZE_BUCKETS];
+
+// frame_len без FCS, короткие кадры считаются как 64
+inline size_t size_bucket(uint32_t frame_len) {
+    uint32_t wire_len = frame_len + 4;
+    if (wire_len <= 64) {
+        return 0;
+    }
+    if (wire_len > 1518) {
+        return SIZE_BUCKETS - 1;
+    }
+    return std::bit_width(wire_len) - 6;
+}
+
+// Состояния потока приёма (--poll)
+enum PollState { POLL_BUSY, POLL_SPIN, POLL_PAUSE, POLL_SLEEP, POLL_WAIT };
+constexpr size_t POLL_STATES = 5;
+extern const char *const POLL_STATE_NAMES[POLL_STATES];
+
+// Счётчики одного потока, выровнены по кэш-линии
+struct alignas(64) WorkerStats {
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> good_packets{0};  // кадры с заголовком теста (приём)
+    std::atomic<uint64_t> good_bytes{0};
+    std::atomic<uint64_t> empty_polls{0};   // только для опроса
+    std::atomic<uint64_t> drops{0};         // отброшенные кадры
+    std::array<std::atomic<uint64_t>, SIZE_BUCKETS> sizes{};  // кадры теста по размерам (приём)
+    std::array<std::atomic<uint64_t>, POLL_STATES> poll_cycles{};  // такты TSC по состояниям опроса (приём)
+
+    void add(uint64_t nb_packets, uint64_t nb_bytes) {
+        // Один писатель: load/store без блокирующей операции
+        packets.store(packets.load(std::memory_order_relaxed) + nb_packets, std::memory_order_relaxed);
+        bytes.store(bytes.load(std::memory_order_relaxed) + nb_bytes, std::memory_order_relaxed);
+    }
+
+    void add_good(uint64_t nb_packets, uint64_t nb_bytes) {
+        good_packets.store(good_packets.load(std::memory_order_relaxed) + nb_packets, std::memory_order_relaxed);
+        good_bytes.store(good_bytes.load(std::memory_order_relaxed) + nb_bytes, std::memory_order_relaxed);
+    }
+
+    void add_empty_poll() {
+        empty_polls.store(empty_polls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void add_drops(uint64_t nb_packets) {
+        drops.store(drops.load(std::memory_order_relaxed) + nb_packets, std::memory_order_relaxed);
+    }
+
+    void add_size(uint32_t frame_len) {
+        std::atomic<uint64_t> &bucket = sizes[size_bucket(frame_len)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void add_poll_cycles(PollState state, uint64_t cycles) {
+        std::atomic<uint64_t> &counter = poll_cycles[state];
+        counter.store(counter.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+    }
+};
+
+struct StatsSnapshot {
+    std::chrono::steady_clock::time_point time;
+    uint64_t packets = 0;
+    uint64_t bytes = 0;
+    uint64_t good_packets = 0;
+    uint64_t good_bytes = 0;
+    uint64_t drops = 0;
+};
+
+// Счётчики всех потоков; скорость считается по разнице снимков
+struct Stats {
+    std::vector<WorkerStats> workers = std::vector<WorkerStats>(1);
+    StatsSnapshot last;
+    std::chrono::steady_clock::time_point start_time;
+
+    StatsSnapshot snapshot() const;
+    StatsSnapshot snapshot(size_t worker) const;
+    void start(size_t nb_workers);
+};
+
+std::string format_unit(double value);
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <x86intrin.h>
+
+// Частота TSC, измеряется один раз по steady_clock
+inline uint64_t tsc_hz() {
+    static const uint64_t hz = [] {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        uint64_t c1 = __rdtsc();
+        auto t1 = std::chrono::steady_clock::now();
+        return static_cast<uint64_t>((c1 - c0) / std::chrono::duration<double>(t1 - t0).count());
+    }();
+    return hz;
+}
+
+// Token bucket по тактам TSC: токены - пакеты (--rate-pps) или биты (--rate-bps)
+class TokenBucket {
+public:
+    TokenBucket() = default;
+
+    // rate == 0 отключает ограничение
+    TokenBucket(double rate_per_sec, uint64_t cycles_per_sec, double burst_tokens)
+        : cycles_per_token(rate_per_sec > 0 ? cycles_per_sec / rate_per_sec : 0),
+          hz(cycles_per_sec),
+          depth(std::max(burst_tokens, 1.0)) {}
+
+    bool enabled() const { return cycles_per_token > 0; }
+
+    // Сколько элементов стоимостью cost можно отправить сейчас, не больше max_items
+    uint32_t available(uint64_t now, double cost, uint32_t max_items) {
+        refill(now);
+        double items = tokens / cost;
+        if (items < 1) {
+            return 0;  // токены могут уйти в минус после длинных кадров
+        }
+        return items >= max_items ? max_items : static_cast<uint32_t>(items);
+    }
+
+    void consume(double tokens_used) { tokens -= tokens_used; }
+
+    // Списание отправленного: кадры или биты по фактической длине
+    void consume_sent(uint64_t packets, uint64_t bytes) { tokens -= per_bit ? bytes * 8.0 : packets; }
+
+    // Токены - биты (--rate-bps)
+    bool per_bit = false;
+
+    // Ожидание хотя бы одного элемента; долгие ожидания отдают CPU
+    template <typename Clock, typename Stop>
+    uint32_t wait(Clock now_fn, double cost, uint32_t max_items, const Stop &stop) {
+        for (;;) {
+            uint64_t now = now_fn();
+            uint32_t n = available(now, cost, max_items);
+            if (n > 0 || stop()) {
+                return n;
+            }
+            double missing_cycles = (cost - tokens) * cycles_per_token;
+            if (missing_cycles * 1e6 > 50.0 * hz) {
+                std::this_thread::yield();
+            } else {
+                _mm_pause();
+            }
+        }
+    }
+
+private:
+    double cycles_per_token = 0;
+    double hz = 0;
+    double depth = 1;
+    double tokens = 0;
+    uint64_t last = 0;
+
+    void refill(uint64_t now) {
+        if (last == 0) {
+            last = now;
+            tokens = depth;
+            return;
+        }
+        tokens = std::min(depth, tokens + (now - last) / cycles_per_token);
+        last = now;
+    }
+};
+
+// Доля нагрузки процесса на один поток; *cost - оценка токенов на кадр для wait()
+inline TokenBucket make_pacer(double rate_pps, double rate_bps, unsigned nb_workers, double frame_len,
+                              unsigned burst, uint64_t cycles_per_sec, double *cost) {
+    if (rate_bps > 0) {
+        *cost = frame_len * 8.0;
+        TokenBucket bucket(rate_bps / nb_workers, cycles_per_sec, burst * *cost);
+        bucket.per_bit = true;
+        return bucket;
+    }
+    *cost = 1.0;
+    return TokenBucket(rate_pps / nb_workers, cycles_per_sec, burst);
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Минимальная обёртка io_uring без liburing, одно кольцо на поток
+struct Uring {
+    int fd = -1;
+    bool sqpoll = false;
+
+    uint32_t *sq_head = nullptr;
+    uint32_t *sq_tail = nullptr;
+    uint32_t *sq_flags = nullptr;
+    uint32_t *sq_array = nullptr;
+    uint32_t sq_mask = 0;
+    uint32_t sq_entries = 0;
+    struct io_uring_sqe *sqes = nullptr;
+    uint32_t sqe_tail = 0;  // локальный tail, публикуется в submit()
+
+    uint32_t *cq_head = nullptr;
+    uint32_t *cq_tail = nullptr;
+    uint32_t cq_mask = 0;
+    struct io_uring_cqe *cqes = nullptr;
+
+    void *sq_map = nullptr;
+    size_t sq_map_size = 0;
+    void *cq_map = nullptr;
+    size_t cq_map_size = 0;
+    size_t sqes_size = 0;
+
+    // Свободный SQE или nullptr, если очередь полна
+    struct io_uring_sqe *get_sqe() {
+        uint32_t head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+        if (sqe_tail - head >= sq_entries) {
+            return nullptr;
+        }
+        struct io_uring_sqe *sqe = &sqes[sqe_tail & sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        sq_array[sqe_tail & sq_mask] = sqe_tail & sq_mask;
+        sqe_tail++;
+        return sqe;
+    }
+
+    // Отправка SQE; с wait ожидание хотя бы одного завершения
+    int submit(bool wait) {
+        uint32_t tail = *sq_tail;
+        uint32_t to_submit = sqe_tail - tail;
+        __atomic_store_n(sq_tail, sqe_tail, __ATOMIC_RELEASE);
+        if (sqpoll) {
+            // Запись tail должна быть видна до чтения флага
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+            if (__atomic_load_n(sq_flags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP) {
+                flags |= IORING_ENTER_SQ_WAKEUP;
+            }
+            return flags ? enter(0, wait ? 1 : 0, flags) : 0;
+        }
+        if (to_submit == 0 && !wait) {
+            return 0;
+        }
+        return enter(to_submit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+    }
+
+    // Ожидание завершения или timeout_ms
+    int wait_cqe(unsigned timeout_ms) {
+        struct __kernel_timespec ts = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000LL};
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        return syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+
+    // Вызов fn(cqe) для каждого завершения, возвращает их число
+    template <typename Fn>
+    unsigned for_each_cqe(Fn fn) {
+        uint32_t head = *cq_head;
+        uint32_t tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        unsigned n = 0;
+        for (; head != tail; head++, n++) {
+            fn(cqes[head & cq_mask]);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+        return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+    }
+};
+
+// Создание кольца; SQPOLL до ядра 5.11 требует CAP_SYS_NICE
+inline bool uring_init(Uring *ring, unsigned entries, bool sqpoll) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (sqpoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = 1000;  // мс простоя до сна потока опроса
+    }
+    ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        perror("io_uring_setup failed");
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        fprintf(stderr, "io_uring: kernel 5.11 or newer is required\n");
+        return false;
+    }
+    ring->sqpoll = sqpoll;
+
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->sq_map_size = ring->cq_map_size = std::max(ring->sq_map_size, ring->cq_map_size);
+    }
+    ring->sq_map = mmap(nullptr, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) {
+        perror("mmap io_uring SQ failed");
+        ring->sq_map = nullptr;
+        return false;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_map = ring->sq_map;
+    } else {
+        ring->cq_map = mmap(nullptr, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) {
+            perror("mmap io_uring CQ failed");
+            ring->cq_map = nullptr;
+            return false;
+        }
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        perror("mmap io_uring SQEs failed");
+        return false;
+    }
+    ring->sqes = static_cast<struct io_uring_sqe *>(sqes);
+
+    auto *sq = static_cast<uint8_t *>(ring->sq_map);
+    ring->sq_head = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+    ring->sq_tail = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+    ring->sq_flags = reinterpret_cast<uint32_t *>(sq + params.sq_off.flags);
+    ring->sq_array = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+    ring->sq_mask = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+    ring->sq_entries = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_entries);
+    ring->sqe_tail = *ring->sq_tail;
+
+    auto *cq = static_cast<uint8_t *>(ring->cq_map);
+    ring->cq_head = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+    ring->cq_tail = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+    ring->cq_mask = *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+    return true;
+}
+
+inline void uring_close(Uring *ring) {
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_map && ring->cq_map != ring->sq_map) {
+        munmap(ring->cq_map, ring->cq_map_size);
+    }
+    if (ring->sq_map) {
+        munmap(ring->sq_map, ring->sq_map_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+}
+
+// Регистрация файла и буфера с индексом 0
+inline bool uring_register(Uring *ring, int sockfd, void *buf, size_t len) {
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, &sockfd, 1) < 0) {
+        perror("IORING_REGISTER_FILES failed");
+        return false;
+    }
+    struct iovec iov = {buf, len};
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0) {
+        perror("IORING_REGISTER_BUFFERS failed");
+        return false;
+    }
+    return true;
+}
+
+// write()/read() одного кадра через зарегистрированные файл и буфер
+inline void uring_prep_fixed(struct io_uring_sqe *sqe, uint8_t opcode, void *data, unsigned len, uint64_t user_data) {
+    sqe->opcode = opcode;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = 0;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = len;
+    sqe->buf_index = 0;
+    sqe->user_data = user_data;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+
+#include "engine.h"
+#include "frame.h"
+#include "options.h"
+#include "size_schedule.h"
+#include "xdp_socket.h"
+
+// Отправка через AF_XDP: один сокет на --queue, пакеты по --batch
+class XdpTxEngine : public TxEngine {
+public:
+    explicit XdpTxEngine(const Options &opts) : opts(opts) {}
+    ~XdpTxEngine() override { xsk_close(&xsk); }
+
+    bool setup() override;
+    void transmit(unsigned worker_id, WorkerStats &stats) override;
+    void device_counters(DeviceCounters *counters) override;
+
+private:
+    const Options &opts;
+    XskSocket xsk;
+    std::vector<uint8_t> frame;
+    SizeSchedule sizes;
+    FlowTable flows;
+    unsigned batch_size = 64;
+};
+
+// Приём через AF_XDP: один сокет на --queue, с --reflect кадры отправляются обратно
+class XdpRxEngine : public RxEngine {
+public:
+    explicit XdpRxEngine(const Options &opts) : opts(opts) {}
+    ~XdpRxEngine() override;
+
+    bool setup() override;
+    void receive(unsigned worker_id, WorkerStats &stats, StreamTable &streams) override;
+    void device_counters(DeviceCounters *counters) override;
+
+private:
+    const Options &opts;
+    XskSocket xsk;
+    int map_fd = -1;
+    int link_fd = -1;
+    unsigned batch_size = 64;
+
+    void refill(const uint64_t *addrs, uint32_t n);
+};
@@ -0,0 +1,158 @@
+#include "xdp_engine.h"
+
+#include <algorithm>
+#include <iostream>
+#include <net/if.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "runner.h"
+
+bool XdpRxEngine::setup() {
+    uint16_t bind_flags;
+    if (!parse_xdp_bind_mode(opts.bind, &bind_flags)) {
+        return false;
+    }
+    uint32_t xdp_flags;
+    if (opts.xdp_mode == "native") {
+        xdp_flags = XDP_FLAGS_DRV_MODE;
+    } else if (opts.xdp_mode == "generic") {
+        xdp_flags = XDP_FLAGS_SKB_MODE;
+    } else {
+        std::cerr << "Unknown XDP mode: " << opts.xdp_mode << " (expected native or generic)" << std::endl;
+        return false;
+    }
+    batch_size = std::min(opts.batch, XSK_RING_SIZE);
+
+    unsigned ifindex = if_nametoindex(opts.iface.c_str());
+    if (ifindex == 0) {
+        perror("if_nametoindex failed");
+        return false;
+    }
+
+    configure_buffers(opts);
+    if (!xsk_open(ifindex, opts.queue, bind_flags, true, opts.reflect, &xsk)) {
+        return false;
+    }
+
+    link_fd = xdp_attach_redirect(ifindex, xdp_flags, &map_fd);
+    if (link_fd < 0 && xdp_flags == XDP_FLAGS_DRV_MODE) {
+        std::cerr << "Native XDP unavailable, falling back to generic mode" << std::endl;
+        close(map_fd);
+        link_fd = xdp_attach_redirect(ifindex, XDP_FLAGS_SKB_MODE, &map_fd);
+    }
+    if (link_fd < 0 || !xsk_map_update(map_fd, opts.queue, xsk.fd)) {
+        return false;
+    }
+    std::cout << "AF_XDP socket on " << opts.iface << " queue " << opts.queue
+              << (xsk.umem_buffer->in_hugepages() ? ", UMEM in hugepages" : "") << std::endl;
+    return true;
+}
+
+XdpRxEngine::~XdpRxEngine() {
+    if (link_fd >= 0) {
+        close(link_fd);  // отключает программу XDP
+    }
+    if (map_fd >= 0) {
+        close(map_fd);
+    }
+    xsk_close(&xsk);
+}
+
+void XdpRxEngine::device_counters(DeviceCounters *counters) {
+    // Отброшенные сокетом кадры учитываются и в generic XDP
+    read_iface_counters(opts.iface, counters, false);
+    xsk_read_counters(xsk, counters);
+}
+
+// Передача кадров UMEM ядру для приёма
+void XdpRxEngine::refill(const uint64_t *addrs, uint32_t n) {
+    uint32_t idx;
+    uint32_t reserved = xsk.fill.reserve(n, &idx);
+    for (uint32_t i = 0; i < reserved; i++) {
+        *xsk.fill.addr(idx + i) = addrs[i];
+    }
+    xsk.fill.submit();
+}
+
+// Кадры читаются прямо из UMEM; с --reflect отправляются обратно через тот же сокет
+void XdpRxEngine::receive(unsigned /*worker_id*/, WorkerStats &ws, StreamTable &streams) {
+    // В работе не больше кадров, чем вмещает fill ring
+    std::vector<uint64_t> addrs;
+    for (uint32_t i = 0; i < XSK_RING_SIZE; i++) {
+        addrs.push_back(static_cast<uint64_t>(i) * XSK_FRAME_SIZE);
+    }
+    refill(addrs.data(), addrs.size());
+
+    std::vector<uint64_t> recycled(std::max(batch_size, XSK_RING_SIZE));
+    uint32_t tx_outstanding = 0;
+    while (!stop_requested()) {
+        if (opts.reflect && tx_outstanding > 0) {
+            // В режиме копирования ядро будится, пока всё не отправлено
+            if (xsk.tx.needs_wakeup()) {
+                sendto(xsk.fd, nullptr, 0, MSG_DONTWAIT, nullptr, 0);
+            }
+            uint32_t idx;
+            uint32_t done = xsk.comp.peek(XSK_RING_SIZE, &idx);
+            for (uint32_t i = 0; i < done; i++) {
+                recycled[i] = *xsk.comp.addr(idx + i);
+            }
+            if (done > 0) {
+                xsk.comp.release();
+                refill(recycled.data(), done);
+                tx_outstanding -= done;
+            }
+        }
+
+        uint32_t idx;
+        uint32_t n = xsk.rx.peek(batch_size, &idx);
+        if (n == 0) {
+            // Нет кадров: poll() только если драйверу нужен wakeup
+            if (xsk.fill.needs_wakeup() && tx_outstanding == 0) {
+                struct pollfd pfd = {xsk.fd, POLLIN, 0};
+                poll(&pfd, 1, 100);
+            }
+            continue;
+        }
+
+        uint32_t tx_idx = 0;
+        uint32_t tx_n = opts.reflect ? xsk.tx.reserve(n, &tx_idx) : 0;
+        uint32_t nb_recycled = 0, nb_reflected = 0;
+        uint64_t bytes = 0;
+        uint64_t good = 0, good_bytes = 0;
+        for (uint32_t i = 0; i < n; i++) {
+            const struct xdp_desc *desc = xsk.rx.desc(idx + i);
+            uint8_t *frame = xsk.frame(desc->addr);
+            bytes += desc->len;
+            bool is_bench = streams.record(frame, desc->len);
+            if (is_bench) {
+                good++;
+                good_bytes += desc->len;
+                ws.add_size(desc->len);
+            }
+            if (is_bench && nb_reflected < tx_n) {
+                bench_reflect(frame);
+                struct xdp_desc *out = xsk.tx.desc(tx_idx + nb_reflected++);
+                out->addr = desc->addr;
+                out->len = desc->len;
+                out->options = 0;
+            } else {
+                recycled[nb_recycled++] = desc->addr & ~static_cast<uint64_t>(XSK_FRAME_SIZE - 1);
+            }
+        }
+        xsk.rx.release();
+        refill(recycled.data(), nb_recycled);
+
+        if (opts.reflect) {
+            // Неиспользованные места TX возвращаются
+            xsk.tx.cached_prod -= tx_n - nb_reflected;
+            if (nb_reflected > 0) {
+                xsk.tx.submit();
+                tx_outstanding += nb_reflected;
+            }
+        }
+
+        ws.add(n, bytes);
+        ws.add_good(good, good_bytes);
+    }
+}
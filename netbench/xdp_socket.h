@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "device_counters.h"
+#include "placement.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+// Общий код AF_XDP, без libbpf/libxdp
+
+constexpr uint32_t XSK_FRAME_SIZE = 2048;
+constexpr uint32_t XSK_NUM_FRAMES = 4096;
+constexpr uint32_t XSK_RING_SIZE = 2048;
+
+// Отступ ядра перед каждым принятым кадром
+constexpr uint32_t XSK_RX_MAX_FRAME = XSK_FRAME_SIZE - XDP_PACKET_HEADROOM;
+
+// Кольцо, общее с ядром
+struct XskRing {
+    uint32_t *producer = nullptr;
+    uint32_t *consumer = nullptr;
+    uint32_t *flags = nullptr;
+    void *ring = nullptr;
+    void *map = nullptr;
+    size_t map_size = 0;
+    uint32_t mask = 0;
+    uint32_t size = 0;
+    uint32_t cached_prod = 0;
+    uint32_t cached_cons = 0;
+
+    uint64_t *addr(uint32_t idx) { return static_cast<uint64_t *>(ring) + (idx & mask); }
+    struct xdp_desc *desc(uint32_t idx) { return static_cast<struct xdp_desc *>(ring) + (idx & mask); }
+
+    // Производитель (fill и TX): резервирует до n мест
+    uint32_t reserve(uint32_t n, uint32_t *idx) {
+        uint32_t free_entries = size - (cached_prod - cached_cons);
+        if (free_entries < n) {
+            cached_cons = __atomic_load_n(consumer, __ATOMIC_ACQUIRE);
+            free_entries = size - (cached_prod - cached_cons);
+        }
+        n = n < free_entries ? n : free_entries;
+        *idx = cached_prod;
+        cached_prod += n;
+        return n;
+    }
+
+    void submit() { __atomic_store_n(producer, cached_prod, __ATOMIC_RELEASE); }
+
+    // Потребитель (completion и RX): до n заполненных мест
+    uint32_t peek(uint32_t n, uint32_t *idx) {
+        uint32_t entries = cached_prod - cached_cons;
+        if (entries == 0) {
+            cached_prod = __atomic_load_n(producer, __ATOMIC_ACQUIRE);
+            entries = cached_prod - cached_cons;
+        }
+        n = n < entries ? n : entries;
+        *idx = cached_cons;
+        cached_cons += n;
+        return n;
+    }
+
+    void release() { __atomic_store_n(consumer, cached_cons, __ATOMIC_RELEASE); }
+
+    bool needs_wakeup() const { return __atomic_load_n(flags, __ATOMIC_RELAXED) & XDP_RING_NEED_WAKEUP; }
+};
+
+struct XskSocket {
+    int fd = -1;
+    std::unique_ptr<FrameBuffer> umem_buffer;
+    uint8_t *umem = nullptr;
+    XskRing fill, comp, rx, tx;
+
+    uint8_t *frame(uint64_t addr) { return umem + addr; }
+};
+
+// UMEM - буфер кадров (--hugepages, узел NIC), см. FrameBuffer
+inline bool xsk_alloc_umem(XskSocket *xsk) {
+    xsk->umem_buffer = std::make_unique<FrameBuffer>(static_cast<size_t>(XSK_NUM_FRAMES) * XSK_FRAME_SIZE);
+    xsk->umem = xsk->umem_buffer->data();
+    return xsk->umem != nullptr;
+}
+
+inline bool xsk_map_ring(int fd, const struct xdp_ring_offset &off, uint64_t pgoff, size_t entry_size, XskRing *ring) {
+    ring->size = XSK_RING_SIZE;
+    ring->mask = XSK_RING_SIZE - 1;
+    ring->map_size = off.desc + XSK_RING_SIZE * entry_size;
+    ring->map = mmap(nullptr, ring->map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, pgoff);
+    if (ring->map == MAP_FAILED) {
+        perror("mmap XDP ring failed");
+        ring->map = nullptr;
+        return false;
+    }
+    auto *base = static_cast<uint8_t *>(ring->map);
+    ring->producer = reinterpret_cast<uint32_t *>(base + off.producer);
+    ring->consumer = reinterpret_cast<uint32_t *>(base + off.consumer);
+    ring->flags = reinterpret_cast<uint32_t *>(base + off.flags);
+    ring->ring = base + off.desc;
+    ring->cached_prod = *ring->producer;
+    ring->cached_cons = *ring->consumer;
+    return true;
+}
+
+inline void xsk_close(XskSocket *xsk) {
+    for (XskRing *ring : {&xsk->fill, &xsk->comp, &xsk->rx, &xsk->tx}) {
+        if (ring->map) {
+            munmap(ring->map, ring->map_size);
+        }
+    }
+    if (xsk->fd >= 0) {
+        close(xsk->fd);
+    }
+    xsk->umem_buffer.reset();
+    xsk->umem = nullptr;
+}
+
+// Создание сокета, регистрация UMEM и колец, привязка к очереди
+inline bool xsk_open(unsigned ifindex, unsigned queue_id, uint16_t bind_flags, bool with_rx, bool with_tx, XskSocket *xsk) {
+    if (!xsk_alloc_umem(xsk)) {
+        return false;
+    }
+    xsk->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (xsk->fd < 0) {
+        perror("AF_XDP socket creation failed");
+        return false;
+    }
+
+    struct xdp_umem_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = reinterpret_cast<uint64_t>(xsk->umem);
+    reg.len = xsk->umem_buffer->size();
+    reg.chunk_size = XSK_FRAME_SIZE;
+    if (setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_REG, &reg, sizeof(reg)) < 0) {
+        perror("setsockopt XDP_UMEM_REG failed");
+        return false;
+    }
+
+    // Ядро требует оба кольца UMEM
+    uint32_t ring_size = XSK_RING_SIZE;
+    if (setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size, sizeof(ring_size)) < 0 ||
+        setsockopt(xsk->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size, sizeof(ring_size)) < 0 ||
+        (with_rx && setsockopt(xsk->fd, SOL_XDP, XDP_RX_RING, &ring_size, sizeof(ring_size)) < 0) ||
+        (with_tx && setsockopt(xsk->fd, SOL_XDP, XDP_TX_RING, &ring_size, sizeof(ring_size)) < 0)) {
+        perror("setsockopt XDP ring size failed");
+        return false;
+    }
+
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if (getsockopt(xsk->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen) < 0) {
+        perror("getsockopt XDP_MMAP_OFFSETS failed");
+        return false;
+    }
+    if (!xsk_map_ring(xsk->fd, off.fr, XDP_UMEM_PGOFF_FILL_RING, sizeof(uint64_t), &xsk->fill) ||
+        !xsk_map_ring(xsk->fd, off.cr, XDP_UMEM_PGOFF_COMPLETION_RING, sizeof(uint64_t), &xsk->comp) ||
+        (with_rx && !xsk_map_ring(xsk->fd, off.rx, XDP_PGOFF_RX_RING, sizeof(struct xdp_desc), &xsk->rx)) ||
+        (with_tx && !xsk_map_ring(xsk->fd, off.tx, XDP_PGOFF_TX_RING, sizeof(struct xdp_desc), &xsk->tx))) {
+        return false;
+    }
+
+    struct sockaddr_xdp sxdp;
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = ifindex;
+    sxdp.sxdp_queue_id = queue_id;
+    sxdp.sxdp_flags = bind_flags | XDP_USE_NEED_WAKEUP;
+    if (bind(xsk->fd, reinterpret_cast<struct sockaddr *>(&sxdp), sizeof(sxdp)) < 0) {
+        perror((bind_flags & XDP_ZEROCOPY) ? "AF_XDP bind (zero-copy) failed" : "AF_XDP bind failed");
+        return false;
+    }
+    return true;
+}
+
+// XDP_STATISTICS сокета
+inline void xsk_read_counters(const XskSocket &xsk, DeviceCounters *counters) {
+    struct xdp_statistics st;
+    memset(&st, 0, sizeof(st));
+    socklen_t len = sizeof(st);
+    if (xsk.fd < 0 || getsockopt(xsk.fd, SOL_XDP, XDP_STATISTICS, &st, &len) < 0) {
+        return;
+    }
+    counters->push_back(DeviceCounter{"xsk_rx_ring_full", st.rx_ring_full, CounterKind::QueueFull});
+    counters->push_back(DeviceCounter{"xsk_rx_fill_ring_empty", st.rx_fill_ring_empty_descs, CounterKind::NoBuffers});
+    counters->push_back(DeviceCounter{"xsk_rx_dropped", st.rx_dropped, CounterKind::Info});
+    counters->push_back(DeviceCounter{"xsk_rx_invalid_descs", st.rx_invalid_descs, CounterKind::Error});
+    counters->push_back(DeviceCounter{"xsk_tx_invalid_descs", st.tx_invalid_descs, CounterKind::Error});
+}
+
+inline long bpf_call(int cmd, union bpf_attr *attr) {
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+// Программа XDP: кадры очереди с сокетом перенаправляются в него, остальные XDP_PASS
+//   r2 = ctx->rx_queue_index
+//   r1 = &xsks_map
+//   r3 = XDP_PASS
+//   return bpf_redirect_map(r1, r2, r3)
+inline int xdp_load_redirect_prog(int map_fd) {
+    struct bpf_insn prog[] = {
+        {BPF_LDX | BPF_MEM | BPF_W, BPF_REG_2, BPF_REG_1, offsetof(struct xdp_md, rx_queue_index), 0},
+        {BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd},
+        {0, 0, 0, 0, 0},
+        {BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS},
+        {BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map},
+        {BPF_JMP | BPF_EXIT, 0, 0, 0, 0},
+    };
+    static const char license[] = "GPL";
+    static char log_buf[4096];
+
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = reinterpret_cast<uint64_t>(prog);
+    attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+    attr.license = reinterpret_cast<uint64_t>(license);
+    attr.log_buf = reinterpret_cast<uint64_t>(log_buf);
+    attr.log_size = sizeof(log_buf);
+    attr.log_level = 1;
+    int fd = bpf_call(BPF_PROG_LOAD, &attr);
+    if (fd < 0) {
+        perror("BPF_PROG_LOAD failed");
+        std::cerr << log_buf << std::endl;
+    }
+    return fd;
+}
+
+// Подключение программы через BPF link; -1 при ошибке
+inline int xdp_attach_redirect(unsigned ifindex, uint32_t xdp_flags, int *map_fd) {
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = 64;
+    *map_fd = bpf_call(BPF_MAP_CREATE, &attr);
+    if (*map_fd < 0) {
+        perror("BPF_MAP_CREATE (XSKMAP) failed");
+        return -1;
+    }
+
+    int prog_fd = xdp_load_redirect_prog(*map_fd);
+    if (prog_fd < 0) {
+        return -1;
+    }
+
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = prog_fd;
+    attr.link_create.target_ifindex = ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = xdp_flags;
+    int link_fd = bpf_call(BPF_LINK_CREATE, &attr);
+    if (link_fd < 0) {
+        perror("attaching XDP program failed");
+    }
+    close(prog_fd);  // программу держит link
+    return link_fd;
+}
+
+inline bool xsk_map_update(int map_fd, uint32_t queue_id, int xsk_fd) {
+    uint32_t value = xsk_fd;
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = reinterpret_cast<uint64_t>(&queue_id);
+    attr.value = reinterpret_cast<uint64_t>(&value);
+    attr.flags = BPF_ANY;
+    if (bpf_call(BPF_MAP_UPDATE_ELEM, &attr) < 0) {
+        perror("BPF_MAP_UPDATE_ELEM (XSKMAP) failed");
+        return false;
+    }
+    return true;
+}
+
+// Разбор --bind auto|copy|zero-copy
+inline bool parse_xdp_bind_mode(const std::string &mode, uint16_t *bind_flags) {
+    if (mode == "auto") {
+        *bind_flags = 0;
+    } else if (mode == "copy") {
+        *bind_flags = XDP_COPY;
+    } else if (mode == "zero-copy") {
+        *bind_flags = XDP_ZEROCOPY;
+    } else {
+        std::cerr << "Unknown bind mode: " << mode << " (expected auto, copy or zero-copy)" << std::endl;
+        return false;
+    }
+    return true;
+}
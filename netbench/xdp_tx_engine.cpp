@@ -0,0 +1,120 @@
+#include "xdp_engine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "runner.h"
+#include "token_bucket.h"
+
+bool XdpTxEngine::setup() {
+    if (!opts.replay.empty()) {
+        // Кадры должны лежать в UMEM
+        std::cerr << "--replay is supported by the socket and DPDK senders" << std::endl;
+        return false;
+    }
+    uint16_t bind_flags;
+    if (!parse_xdp_bind_mode(opts.bind, &bind_flags)) {
+        return false;
+    }
+    batch_size = std::min(opts.batch, XSK_RING_SIZE);
+
+    unsigned ifindex = if_nametoindex(opts.iface.c_str());
+    if (ifindex == 0) {
+        perror("if_nametoindex failed");
+        return false;
+    }
+
+    // Каждый кадр вмещает заголовок теста и помещается в блок UMEM
+    if (!SizeSchedule::build(opts, sizeof(struct ether_header), BENCH_MIN_FRAME, XSK_FRAME_SIZE, &sizes)) {
+        return false;
+    }
+    uint8_t src_mac[6] = {};
+    get_mac_address(opts.iface.c_str(), src_mac);
+    flows = FlowTable(src_mac, opts.dst_mac.data(), opts.flows);
+    frame = build_bench_frame(flows, sizes.max(), 0);
+
+    configure_buffers(opts);
+    if (!xsk_open(ifindex, opts.queue, bind_flags, false, true, &xsk)) {
+        return false;
+    }
+    std::cout << "AF_XDP socket on " << opts.iface << " queue " << opts.queue
+              << (xsk.umem_buffer->in_hugepages() ? ", UMEM in hugepages" : "") << std::endl;
+    return true;
+}
+
+// Кадры UMEM заполняются один раз, в цикле меняются только номер и заголовки потока
+void XdpTxEngine::transmit(unsigned /*worker_id*/, WorkerStats &ws) {
+    std::vector<uint64_t> free_frames;
+    free_frames.reserve(XSK_NUM_FRAMES);
+    for (uint32_t i = 0; i < XSK_NUM_FRAMES; i++) {
+        uint64_t addr = static_cast<uint64_t>(i) * XSK_FRAME_SIZE;
+        memcpy(xsk.frame(addr), frame.data(), frame.size());
+        free_frames.push_back(addr);
+    }
+
+    uint64_t seq = 0;
+    SizeSchedule::Cursor frame_sizes = sizes.cursor(0, 1);
+    unsigned flow = 0;
+    double cost;
+    TokenBucket pacer = make_pacer(opts.rate_pps, opts.rate_bps, nb_workers(), sizes.mean(), batch_size, tsc_hz(), &cost);
+    while (!stop_requested()) {
+        // Отправленные кадры возвращаются в список свободных
+        uint32_t idx;
+        uint32_t done = xsk.comp.peek(XSK_RING_SIZE, &idx);
+        for (uint32_t i = 0; i < done; i++) {
+            free_frames.push_back(*xsk.comp.addr(idx + i));
+        }
+        if (done > 0) {
+            xsk.comp.release();
+        }
+
+        unsigned count = std::min<size_t>(batch_size, free_frames.size());
+        if (pacer.enabled() && count > 0) {
+            count = pacer.wait([] { return __rdtsc(); }, cost, count, stop_requested);
+        }
+        count = xsk.tx.reserve(count, &idx);
+        uint64_t bytes = 0;
+        for (unsigned i = 0; i < count; i++) {
+            uint64_t addr = free_frames.back();
+            free_frames.pop_back();
+            struct xdp_desc *desc = xsk.tx.desc(idx + i);
+            desc->addr = addr;
+            desc->len = frame_sizes.next();
+            bench_header_set_seq(xsk.frame(addr), seq++);
+            flows.write_headers(xsk.frame(addr), flow, desc->len);
+            flow = flows.next(flow);
+            desc->options = 0;
+            bytes += desc->len;
+        }
+        if (count > 0) {
+            xsk.tx.submit();
+            pacer.consume_sent(count, bytes);
+            ws.add(count, bytes);
+        }
+
+        // В режиме копирования системный вызов нужен всегда
+        if (xsk.tx.needs_wakeup() || done == 0) {
+            if (sendto(xsk.fd, nullptr, 0, MSG_DONTWAIT, nullptr, 0) < 0 &&
+                errno != EAGAIN && errno != EBUSY && errno != ENOBUFS && errno != ENETDOWN) {
+                perror("AF_XDP TX kick failed");
+                break;
+            }
+        }
+
+        if (opts.use_sleep) {
+            usleep(1000);  // Пауза для демонстрации
+        }
+    }
+}
+
+void XdpTxEngine::device_counters(DeviceCounters *counters) {
+    // Отброшенные сокетом кадры учитываются и в generic XDP
+    read_iface_counters(opts.iface, counters, false);
+    xsk_read_counters(xsk, counters);
+}
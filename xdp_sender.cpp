@@ -0,0 +1,12 @@
+#include "options.h"
+#include "runner.h"
+#include "xdp_engine.h"
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    opts.batch = 64;
+    parse_options(argc, argv, &opts);
+
+    XdpTxEngine engine(opts);
+    return run_engine(engine, opts);
+}